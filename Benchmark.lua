@@ -0,0 +1,96 @@
+print("Benchmark.lua start");
+
+-- Per-call cost of usertype properties, integer handles & bulk access
+local count = 200
+local frames = 200
+local calls = count * frames
+
+local function bench(name, fn)
+  local start = os.clock()
+  fn()
+  local elapsed = os.clock() - start
+  print(string.format("%-28s %10.1f ns/call", name, elapsed * 1e9 / calls))
+end
+
+Audio.init()
+
+local sources, ids = {}, {}
+for i = 1, count do
+  sources[i] = Audio.Source.new()
+  ids[i] = sources[i].id
+end
+local GAIN = Audio.Param.Gain
+
+-- Writes
+bench("set: usertype property", function()
+  for f = 1, frames do
+    local gain = f / frames
+    for i = 1, count do
+      sources[i].gain = gain
+    end
+  end
+end)
+
+bench("set: integer handle", function()
+  local setGain = Audio.setGain
+  for f = 1, frames do
+    local gain = f / frames
+    for i = 1, count do
+      setGain(ids[i], gain)
+    end
+  end
+end)
+
+local flat = {}
+bench("set: bulk", function()
+  local setValues = Audio.setValues
+  for f = 1, frames do
+    local gain = f / frames
+    for i = 1, count do
+      local k = (i - 1) * 3
+      flat[k + 1] = ids[i]
+      flat[k + 2] = GAIN
+      flat[k + 3] = gain
+    end
+    setValues(flat)
+  end
+end)
+
+-- Reads
+local sum = 0
+bench("get: usertype property", function()
+  for f = 1, frames do
+    for i = 1, count do
+      sum = sum + sources[i].gain
+    end
+  end
+end)
+
+bench("get: integer handle", function()
+  local getGain = Audio.getGain
+  for f = 1, frames do
+    for i = 1, count do
+      sum = sum + getGain(ids[i])
+    end
+  end
+end)
+
+local query, out = {}, {}
+for i = 1, count do
+  query[i * 2 - 1] = ids[i]
+  query[i * 2] = GAIN
+end
+bench("get: bulk", function()
+  local getValues = Audio.getValues
+  for f = 1, frames do
+    getValues(query, out)
+    for i = 1, count do
+      sum = sum + out[i]
+    end
+  end
+end)
+
+Audio.clearAllSources()
+Audio.terminate()
+
+print("Benchmark.lua end");
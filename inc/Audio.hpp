@@ -3,6 +3,15 @@
 
 #include "Audio/Source.hpp"
 #include "Audio/Buffer.hpp"
+#include "Audio/Engine.hpp"
+#include "Audio/Automation.hpp"
+#include "Audio/Bus.hpp"
+#include "Audio/Effect.hpp"
+#include "Audio/Decoder.hpp"
+#include "Audio/Compression.hpp"
+#include "Audio/Capture.hpp"
+#include "Audio/Analyzer.hpp"
+#include "Audio/Trace.hpp"
 #ifdef SSS_LUA
 #include "Audio/Lua.hpp"
 #endif // SSS_LUA
@@ -0,0 +1,149 @@
+#ifndef SSS_AUDIO_ANALYZER_HPP
+#define SSS_AUDIO_ANALYZER_HPP
+
+#include "Capture.hpp"
+#include <limits>
+
+SSS_AUDIO_BEGIN;
+
+INTERNAL_BEGIN;
+
+// Lock-free latest value exchange between one writer & one reader.
+// Neither side ever waits, the reader always gets the newest value.
+template<typename T>
+class TripleBuffer {
+public:
+    // Writer: fills back(), then publishes it
+    inline T& back() noexcept { return _slots[_back]; };
+    void publish() noexcept
+    {
+        _back = _middle.exchange(_back | _fresh, std::memory_order_acq_rel) & _index;
+    }
+
+    // Reader: takes the latest published value, returns false if none is new
+    bool update() noexcept
+    {
+        if ((_middle.load(std::memory_order_relaxed) & _fresh) == 0)
+            return false;
+        _front = _middle.exchange(_front, std::memory_order_acq_rel) & _index;
+        return true;
+    }
+    inline T const& front() const noexcept { return _slots[_front]; };
+
+private:
+    static constexpr uint8_t _index = 3;
+    static constexpr uint8_t _fresh = 4;
+
+    std::array<T, 3> _slots{};
+    uint8_t _back{ 0 };     // Writer only
+    uint8_t _front{ 1 };    // Reader only
+    alignas(64) std::atomic<uint8_t> _middle{ 2 };
+};
+
+struct AnalysisState; // Pre-declaration
+
+INTERNAL_END;
+
+struct AnalyzerSettings {
+    int fft_size{ 2048 };       // Rounded up to a power of two
+    int block_frames{ 1024 };   // Frames between two results
+    int buffer_frames{ 0 };     // Input ring capacity, 0 for 16 blocks
+};
+
+// Analysis of the last block, levels being linear (1 is full scale)
+struct AnalysisResult {
+    uint64_t blocks{ 0 };       // Blocks analyzed so far
+    int sample_rate{ 0 };
+    float peak{ 0.f };
+    float rms{ 0.f };
+    // ITU-R BS.1770 loudness: 400ms, 3s & gated since start or resetLoudness().
+    // -inf until enough samples were analyzed.
+    float momentary_lufs{ -std::numeric_limits<float>::infinity() };
+    float short_term_lufs{ -std::numeric_limits<float>::infinity() };
+    float integrated_lufs{ -std::numeric_limits<float>::infinity() };
+    // Hann windowed magnitudes in dBFS, bin i being at i * sample_rate / fft_size Hz
+    std::vector<float> spectrum;
+};
+
+// Meter values, each one readable by any thread at the cost of an atomic load
+struct MeterLevels {
+    float peak{ 0.f };
+    float rms{ 0.f };
+    float momentary_lufs{ -std::numeric_limits<float>::infinity() };
+};
+
+// Ignore warning about STL exports as they're private members
+#pragma warning(push, 2)
+#pragma warning(disable: 4251)
+#pragma warning(disable: 4275)
+
+// Meters & spectrum computed on a dedicated thread from samples fed by a
+// single producer: a Source stream (Source::setAnalyzer()), the loopback
+// mix (setMixAnalyzer()), or the user with feed().
+class SSS_AUDIO_API Analyzer final : public Base {
+public:
+    Analyzer(const Analyzer&)             = delete; // Copy constructor
+    Analyzer(Analyzer&&)                  = delete; // Move constructor
+    Analyzer& operator=(const Analyzer&)  = delete; // Copy assignment
+    Analyzer& operator=(Analyzer&&)       = delete; // Move assignment
+    ~Analyzer();
+
+    static Analyzer& create(uint32_t id, AnalyzerSettings const& settings = AnalyzerSettings());
+    static Analyzer& create(AnalyzerSettings const& settings = AnalyzerSettings());
+    static Analyzer* get(uint32_t id) noexcept;
+    static void remove(uint32_t id);
+
+    inline static auto const& getMap() noexcept { return _instances; };
+    static void clearAll() noexcept;
+
+    // Producer side. The first call sets the format (1 or 2 channels),
+    // samples in any other format are dropped.
+    void feed(short const* samples, size_t frames, int channels, int sample_rate) noexcept;
+
+    // Consumer side, from a single thread: the latest result, which stays
+    // valid until the next call
+    AnalysisResult const& getResult() noexcept;
+    // Any thread
+    MeterLevels getLevels() const noexcept;
+    // Restarts the integrated loudness measurement
+    inline void resetLoudness() noexcept { _reset_loudness = true; };
+
+    inline AnalyzerSettings const& getSettings() const noexcept { return _settings; };
+    // Frames the input ring had no room for, or in the wrong format
+    inline uint64_t getDropped() const noexcept { return _dropped; };
+    inline uint32_t getID() const noexcept { return _map_id; };
+
+private:
+    Analyzer(uint32_t id, AnalyzerSettings const& settings);
+
+    void _run();
+    // Analyzes one block from _state's input, then publishes the result
+    void _analyze();
+
+    static std::map<uint32_t, std::unique_ptr<Analyzer>> _instances;
+
+    uint32_t const _map_id;
+    AnalyzerSettings const _settings;
+    _internal::SpscRing<short> _ring;
+    // Set by the first feed()
+    std::atomic<int> _channels{ 0 };
+    std::atomic<int> _sample_rate{ 0 };
+    std::atomic<uint64_t> _dropped{ 0 };
+
+    // Analysis thread only
+    std::unique_ptr<_internal::AnalysisState> _state;
+    _internal::TripleBuffer<AnalysisResult> _results;
+    std::atomic<float> _peak{ 0.f };
+    std::atomic<float> _rms{ 0.f };
+    std::atomic<float> _momentary_lufs{ -std::numeric_limits<float>::infinity() };
+    std::atomic<bool> _reset_loudness{ false };
+
+    std::thread _thread;
+    std::atomic<bool> _running{ false };
+};
+
+#pragma warning(pop)
+
+SSS_AUDIO_END;
+
+#endif // SSS_AUDIO_ANALYZER_HPP
\ No newline at end of file
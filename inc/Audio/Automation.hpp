@@ -0,0 +1,53 @@
+#ifndef SSS_AUDIO_AUTOMATION_HPP
+#define SSS_AUDIO_AUTOMATION_HPP
+
+#include "Engine.hpp"
+
+SSS_AUDIO_BEGIN;
+
+// Shape of a ramp between two values
+enum class Curve {
+    Linear,
+    Exponential,    // Constant ratio per second, suited to gain & pitch
+    SCurve,         // Smoothstep, eases in and out
+    EqualPower,     // Sine/cosine, keeps loudness constant in crossfades
+};
+
+// Value to be reached at given time, in seconds after the envelope starts
+struct EnvelopePoint {
+    float time;
+    float value;
+};
+
+// Fades the first Source out and the second one in over given duration.
+// Automation is evaluated by engine ticks (see startThread() & update()).
+SSS_AUDIO_API void crossfade(uint32_t from_id, uint32_t to_id, float seconds,
+    Curve curve = Curve::EqualPower);
+
+INTERNAL_BEGIN;
+
+enum class Automated {
+    Gain,
+    Pitch,
+    Position,
+};
+
+struct Segment {
+    float duration;
+    std::array<float, 3> target;
+    Curve curve;
+};
+
+// Replaces any automation of given Source parameter
+void automate(uint32_t source_id, Automated param, std::array<float, 3> const& start,
+    std::vector<Segment> segments);
+void stopAutomation(uint32_t source_id, Automated param);
+void stopAutomation(uint32_t source_id);
+// Evaluates and applies all automation lanes, called by engine ticks
+void updateAutomation();
+
+INTERNAL_END;
+
+SSS_AUDIO_END;
+
+#endif // SSS_AUDIO_AUTOMATION_HPP
\ No newline at end of file
@@ -1,7 +1,8 @@
 #ifndef SSS_AUDIO_BUFFER_HPP
 #define SSS_AUDIO_BUFFER_HPP
 
-#include "_includes.hpp"
+#include "Compression.hpp"
+#include "Decoder.hpp"
 
 SSS_AUDIO_BEGIN;
 
@@ -15,6 +16,17 @@ class Source; // Pre-declaration
 #pragma warning(disable: 4251)
 #pragma warning(disable: 4275)
 
+// Resident memory of Buffers, in bytes
+struct BufferMemory {
+    size_t pcm_bytes{ 0 };      // Size as 16 bits PCM
+    size_t stored_bytes{ 0 };   // Size sent to OpenAL
+    inline size_t saved() const noexcept {
+        return pcm_bytes > stored_bytes ? pcm_bytes - stored_bytes : 0;
+    };
+};
+
+// Buffers can be created & loaded before the device is opened,
+// decoded samples are then uploaded once it is.
 class SSS_AUDIO_API Buffer final : public Base {
     friend _internal::Device;
     friend Source;
@@ -33,10 +45,29 @@ public:
     static void remove(uint32_t id);
 
     inline static auto const& getMap() noexcept { return _instances; };
-    inline static void clearAll() noexcept { _instances.clear(); };
+    static void clearAll() noexcept;
 
     void loadFile(std::string const& filename);
 
+    // Format used by the next loadFile() calls, falling back on PCM when
+    // the device doesn't support it
+    void setCompression(Compression const& compression) noexcept;
+    inline Compression getCompression() const noexcept { return _compression; };
+    // Compression of Buffers created from now on
+    static void setDefaultCompression(Compression const& compression) noexcept;
+    inline static Compression getDefaultCompression() noexcept { return _default_compression; };
+
+    // Loop used by Sources with looping enabled (AL_SOFT_loop_points),
+    // read from the file's metadata when loaded. Allows a single Buffer
+    // for an intro followed by a looped body. OpenAL refuses changes
+    // while a Source uses the Buffer.
+    void setLoopPoints(std::optional<LoopPoints> loop);
+    inline std::optional<LoopPoints> getLoopPoints() const noexcept { return _loop_points; };
+
+    inline BufferMemory getMemory() const noexcept { return _memory; };
+    // Sum of every Buffer's memory
+    static BufferMemory getTotalMemory() noexcept;
+
     ALint getProperty(ALenum param) const;
     inline uint32_t getID() const noexcept { return _map_id; };
 
@@ -44,11 +75,42 @@ private:
     Buffer(uint32_t id);
 
     void _removeFromSources() noexcept;
+    void _generate();
+    void _upload();
+    void _applyLoopPoints();
+
+    // Device migration: frees OpenAL buffers, then regenerates them and
+    // reloads their file, or sends their data again if they have none
+    static void _suspendAll();
+    static void _resumeAll();
+    // Uploads Buffers loaded before the device was opened
+    static void _uploadAll();
+
+    // Decoded samples waiting for the device, or as sent to it
+    struct Pending {
+        ALenum format;
+        ALsizei sample_hz;
+        int channels;
+        std::vector<short> samples;
+        std::optional<_internal::Encoded> encoded;
+    };
+    // Encodes pending samples if the device supports _compression
+    void _compress(Pending& pending) const;
 
     static std::map<uint32_t, std::unique_ptr<Buffer>> _instances;
+    static Compression _default_compression;
 
-    ALuint const _openal_id;    // OpenAL id
+    ALuint _openal_id{ 0 };     // OpenAL id, 0 until the device exists
     uint32_t const _map_id;     // _instances id
+    std::string _filename;      // Last loaded file, reloaded on device migration
+    std::unique_ptr<Pending> _pending;
+    // Data sent to OpenAL by Buffers without a file, sent again on device
+    // migration. Buffers with a file don't keep a copy.
+    std::unique_ptr<Pending> _uploaded;
+    std::optional<LoopPoints> _loop_points;
+    size_t _frames{ 0 };        // Uploaded length
+    Compression _compression{ _default_compression };
+    BufferMemory _memory;
 };
 
 #pragma warning(pop)
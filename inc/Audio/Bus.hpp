@@ -0,0 +1,121 @@
+#ifndef SSS_AUDIO_BUS_HPP
+#define SSS_AUDIO_BUS_HPP
+
+#include "Engine.hpp"
+
+SSS_AUDIO_BEGIN;
+
+class Source; // Pre-declaration
+class EffectSlot; // Pre-declaration
+
+INTERNAL_BEGIN;
+// Updates ducking & effective gains, applies them to Sources in one pass
+void updateBuses();
+INTERNAL_END;
+
+// Ignore warning about STL exports as they're private members
+#pragma warning(push, 2)
+#pragma warning(disable: 4251)
+#pragma warning(disable: 4275)
+
+// Named group of Sources (music, SFX, voice...).
+// Buses form a hierarchy: a bus' gain, mute & pause apply to its children.
+class SSS_AUDIO_API Bus final : public Base {
+    friend Source;
+    friend EffectSlot;
+    friend void _internal::updateBuses();
+
+public:
+    Bus(const Bus&)             = delete; // Copy constructor
+    Bus(Bus&&)                  = delete; // Move constructor
+    Bus& operator=(const Bus&)  = delete; // Copy assignment
+    Bus& operator=(Bus&&)       = delete; // Move assignment
+    ~Bus();
+
+    static Bus& create(std::string const& name, std::string const& parent = "");
+    static Bus* get(std::string const& name) noexcept;
+    static void remove(std::string const& name);
+
+    inline static auto const& getMap() noexcept { return _instances; };
+    static void clearAll() noexcept;
+
+    inline std::string const& getName() const noexcept { return _name; };
+    void setParent(std::string const& name);
+    inline std::string const& getParent() const noexcept { return _parent; };
+
+    void setGain(float gain);
+    inline float getGain() const noexcept { return _gain; };
+    void setMuted(bool muted);
+    inline bool isMuted() const noexcept { return _muted; };
+    // Pauses playing Sources of this bus & its children, resumes them afterwards
+    void setPaused(bool paused);
+    bool isPaused() const noexcept;
+
+    // Lowers this bus to given gain while any Source of the trigger bus plays.
+    // Attack & release are time constants, in seconds.
+    void duckUnder(std::string const& trigger, float gain, float attack = 0.05f, float release = 0.5f);
+    void stopDucking(std::string const& trigger);
+
+    // Routes Sources of this bus & its children to an EffectSlot, on send 0.
+    // Sources the user made send elsewhere on send 0 keep their send.
+    void setEffectSlot(uint32_t slot_id);
+    void clearEffectSlot();
+    inline std::optional<uint32_t> getEffectSlot() const noexcept { return _effect_slot; };
+    // Closest EffectSlot set on this bus or its parents
+    std::optional<uint32_t> getInheritedEffectSlot() const noexcept;
+
+    // Gain including parents, mute & ducking, as of the last update
+    inline float getEffectiveGain() const noexcept { return _effective_gain; };
+
+    // Whether this bus is, or is a child of, given bus
+    bool isWithin(std::string const& name) const noexcept;
+
+private:
+    Bus(std::string const& name);
+
+    // Collects Sources assigned to this bus or to its children
+    std::vector<Source*> _getSources() const;
+    // Plays given paused Sources, unless another bus still pauses them
+    static void _resumeSources(std::vector<uint32_t> const& ids);
+
+    struct Ducking {
+        std::string trigger;
+        float gain;
+        float attack;
+        float release;
+        float current{ 1.f };
+        Bus const* trigger_bus{ nullptr };  // Resolved on hierarchy changes
+    };
+
+    static std::map<std::string, std::unique_ptr<Bus>> _instances;
+
+    // Set when names need resolving again (buses, parents, Source buses)
+    static bool _hierarchy_changed;
+    // Set when effective gains need computing again
+    static bool _gains_changed;
+    // Bus of each Source, by Source id, resolved on hierarchy changes
+    static std::vector<Bus*> _source_buses;
+
+    std::string const _name;
+    std::string _parent;
+    float _gain{ 1.f };
+    bool _muted{ false };
+    bool _paused{ false };
+    std::vector<Ducking> _duckings;
+    // Resolved on hierarchy changes
+    Bus* _parent_bus{ nullptr };
+    // Gain with mute & ducking, without parents
+    float _local_gain{ 1.f };
+    float _effective_gain{ 1.f };
+    // Whether a Source of this bus or its children played on the last update
+    bool _triggered{ false };
+    // Sources paused by setPaused, by id
+    std::vector<uint32_t> _paused_sources;
+    std::optional<uint32_t> _effect_slot;
+};
+
+#pragma warning(pop)
+
+SSS_AUDIO_END;
+
+#endif // SSS_AUDIO_BUS_HPP
\ No newline at end of file
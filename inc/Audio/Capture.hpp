@@ -0,0 +1,150 @@
+#ifndef SSS_AUDIO_CAPTURE_HPP
+#define SSS_AUDIO_CAPTURE_HPP
+
+#include "Engine.hpp"
+#include <atomic>
+#include <bit>
+#include <span>
+#include <thread>
+
+SSS_AUDIO_BEGIN;
+
+INTERNAL_BEGIN;
+
+// Lock-free single producer, single consumer ring of samples.
+// Positions only grow, their difference being the readable count.
+template<typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity)
+        : _data(std::bit_ceil(std::max(capacity, size_t(2)))), _mask(_data.size() - 1)
+    {
+    }
+
+    inline size_t capacity() const noexcept { return _data.size(); };
+    inline size_t size() const noexcept {
+        return _write.load(std::memory_order_acquire) - _read.load(std::memory_order_acquire);
+    };
+
+    // Producer: free space as up to two spans, filled then committed
+    std::array<std::span<T>, 2> writable() noexcept
+    {
+        size_t const write = _write.load(std::memory_order_relaxed);
+        size_t const free = capacity() - (write - _read.load(std::memory_order_acquire));
+        return _split<T>(_data.data(), write, free);
+    }
+    void commit(size_t count) noexcept
+    {
+        _write.store(_write.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    // Consumer: readable samples as up to two spans, read then released
+    std::array<std::span<T const>, 2> readable() const noexcept
+    {
+        size_t const read = _read.load(std::memory_order_relaxed);
+        size_t const available = _write.load(std::memory_order_acquire) - read;
+        return _split<T const>(_data.data(), read, available);
+    }
+    void release(size_t count) noexcept
+    {
+        _read.store(_read.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+private:
+    template<typename U, typename Ptr>
+    std::array<std::span<U>, 2> _split(Ptr data, size_t position, size_t count) const noexcept
+    {
+        size_t const start = position & _mask;
+        size_t const first = std::min(count, capacity() - start);
+        return { std::span<U>(data + start, first), std::span<U>(data, count - first) };
+    }
+
+    std::vector<T> _data;
+    size_t const _mask;
+    // Own cache lines, as each is written by a different thread
+    alignas(64) std::atomic<size_t> _write{ 0 };
+    alignas(64) std::atomic<size_t> _read{ 0 };
+};
+
+INTERNAL_END;
+
+struct CaptureSettings {
+    std::string device;         // Empty for the default capture device
+    int frequency{ 48000 };
+    int channels{ 1 };          // 1 or 2, 16 bits samples
+    int period_frames{ 480 };   // Frames drained per wake-up (10ms at 48kHz)
+    int buffer_frames{ 0 };     // Ring capacity, 0 for 32 periods
+};
+
+// Zero-copy view of captured samples (interleaved), valid until consume()
+struct CaptureView {
+    std::span<short const> first;
+    std::span<short const> second;  // Wrapped part, may be empty
+    inline size_t size() const noexcept { return first.size() + second.size(); };
+};
+
+// Ignore warning about STL exports as they're private members
+#pragma warning(push, 2)
+#pragma warning(disable: 4251)
+#pragma warning(disable: 4275)
+
+// Capture device drained by a dedicated thread into a lock-free ring.
+// A single consumer may read it: either the user (peek() & consume(),
+// or read()), or a Source set with Source::streamCapture().
+class SSS_AUDIO_API Capture final : public Base {
+public:
+    Capture(const Capture&)             = delete; // Copy constructor
+    Capture(Capture&&)                  = delete; // Move constructor
+    Capture& operator=(const Capture&)  = delete; // Copy assignment
+    Capture& operator=(Capture&&)       = delete; // Move assignment
+    ~Capture();
+
+    static Capture& create(uint32_t id, CaptureSettings const& settings = CaptureSettings());
+    static Capture& create(CaptureSettings const& settings = CaptureSettings());
+    static Capture* get(uint32_t id) noexcept;
+    static void remove(uint32_t id);
+
+    inline static auto const& getMap() noexcept { return _instances; };
+    static void clearAll() noexcept;
+
+    // Capture devices listed by OpenAL
+    static std::vector<std::string> getDevices();
+
+    void start();
+    void stop();
+    inline bool isRunning() const noexcept { return _running; };
+
+    // Consumer side
+    CaptureView peek() const noexcept;
+    void consume(size_t frames) noexcept;
+    // Copies up to given frame count, returns the frames copied
+    size_t read(short* samples, size_t frames) noexcept;
+    // Drops every captured sample, to catch up after a pause
+    void flush() noexcept;
+
+    inline CaptureSettings const& getSettings() const noexcept { return _settings; };
+    // Frames dropped as the ring had no room for them
+    inline uint64_t getOverruns() const noexcept { return _overruns; };
+    inline uint32_t getID() const noexcept { return _map_id; };
+
+private:
+    Capture(uint32_t id, CaptureSettings const& settings);
+
+    void _run();
+
+    static std::map<uint32_t, std::unique_ptr<Capture>> _instances;
+
+    uint32_t const _map_id;
+    CaptureSettings const _settings;
+    ALCdevice* _device{ nullptr };
+    _internal::SpscRing<short> _ring;
+    std::thread _thread;
+    std::atomic<bool> _running{ false };
+    std::atomic<uint64_t> _overruns{ 0 };
+};
+
+#pragma warning(pop)
+
+SSS_AUDIO_END;
+
+#endif // SSS_AUDIO_CAPTURE_HPP
\ No newline at end of file
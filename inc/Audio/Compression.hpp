@@ -0,0 +1,44 @@
+#ifndef SSS_AUDIO_COMPRESSION_HPP
+#define SSS_AUDIO_COMPRESSION_HPP
+
+#include "Engine.hpp"
+
+SSS_AUDIO_BEGIN;
+
+// In-memory Buffer format. ADPCM formats are decoded natively by the mixer:
+// IMA4 (AL_EXT_IMA4) stores ~4.1 bits per sample, MSADPCM (AL_SOFT_MSADPCM)
+// about as much with a better quality, both ~3.7x smaller than PCM.
+struct Compression {
+    enum class Format {
+        PCM16,
+        IMA4,
+        MSADPCM,
+    };
+    Format format{ Format::PCM16 };
+    // Frames per block, 0 using the format default (IMA4: 65, MSADPCM: 64).
+    // Smaller blocks track transients better, larger ones save header bytes.
+    // Must be 8n+1 for IMA4 & even for MSADPCM, rounded down otherwise.
+    int block_frames{ 0 };
+};
+
+INTERNAL_BEGIN;
+
+// ADPCM blocks, ready to be sent to alBufferData
+struct Encoded {
+    ALenum format{ AL_NONE };
+    ALint block_frames{ 0 };
+    std::vector<uint8_t> data;
+};
+
+// False if the current device can't decode given format
+bool isSupported(Compression::Format format) noexcept;
+// Large inputs are encoded in parallel, within a thread budget shared by
+// concurrent calls. The last block is padded with silence.
+Encoded encodeIMA4(short const* samples, size_t frames, int channels, int block_frames = 0);
+Encoded encodeMSADPCM(short const* samples, size_t frames, int channels, int block_frames = 0);
+
+INTERNAL_END;
+
+SSS_AUDIO_END;
+
+#endif // SSS_AUDIO_COMPRESSION_HPP
\ No newline at end of file
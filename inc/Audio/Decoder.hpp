@@ -0,0 +1,102 @@
+#ifndef SSS_AUDIO_DECODER_HPP
+#define SSS_AUDIO_DECODER_HPP
+
+#include "Engine.hpp"
+
+SSS_AUDIO_BEGIN;
+
+struct AudioInfo {
+    int channels{ 0 };
+    int sample_rate{ 0 };
+    int64_t frames{ 0 };
+};
+
+// Sustain loop, in frames. End is exclusive.
+struct LoopPoints {
+    int64_t start{ 0 };
+    int64_t end{ 0 };
+};
+
+// Decoding backend interface, outputting interleaved 16 bits samples.
+// The default backend relies on libsndfile, faster ones can be registered
+// per file extension with registerDecoder().
+class SSS_AUDIO_API Decoder {
+public:
+    virtual ~Decoder() = default;
+
+    // Returns false if the file can't be decoded by this backend
+    virtual bool open(std::string const& filename) = 0;
+    virtual AudioInfo getInfo() const noexcept = 0;
+    // Returns the number of frames read, 0 at the end of the file
+    virtual size_t read(short* samples, size_t frames) = 0;
+    virtual bool seek(int64_t frame) = 0;
+    // Loop metadata (SMPL chunk, loop tags...), if the file has any
+    virtual std::optional<LoopPoints> getLoopPoints() const { return std::nullopt; };
+};
+
+using DecoderFactory = std::function<std::unique_ptr<Decoder>()>;
+
+// Extensions are lowercase without dot ("mp3"), "*" matching any file.
+// Registering an existing name replaces the backend & resets its stats.
+SSS_AUDIO_API void registerDecoder(std::string const& name,
+    std::vector<std::string> const& extensions, DecoderFactory factory);
+SSS_AUDIO_API void unregisterDecoder(std::string const& name);
+SSS_AUDIO_API std::vector<std::string> getDecoders();
+
+// Decode speed measured per backend & extension during regular use
+struct DecoderStats {
+    std::string name;
+    std::string extension;
+    uint64_t frames{ 0 };
+    double seconds{ 0. };
+    inline double framesPerSecond() const noexcept {
+        return seconds > 0. ? static_cast<double>(frames) / seconds : 0.;
+    };
+};
+SSS_AUDIO_API std::vector<DecoderStats> getDecoderStats();
+
+struct DecoderBenchmark {
+    std::string name;
+    bool supported{ false };        // Whether any run succeeded
+    int runs{ 0 };                  // Successful runs, averaged below
+    double decode_ms{ 0. };         // Average full decode duration
+    double realtime_factor{ 0. };   // Audio duration / decode duration
+};
+// Fully decodes given file with every backend able to, feeding their stats
+SSS_AUDIO_API std::vector<DecoderBenchmark> benchmarkDecoders(std::string const& filename, int runs = 3);
+
+INTERNAL_BEGIN;
+
+// Decoder picked for a file, timing every read into the backend stats
+class DecoderHandle {
+public:
+    DecoderHandle(std::unique_ptr<Decoder> decoder, std::string name, std::string extension);
+    ~DecoderHandle();
+
+    inline AudioInfo getInfo() const noexcept { return _decoder->getInfo(); };
+    size_t read(short* samples, size_t frames);
+    inline bool seek(int64_t frame) { return _decoder->seek(frame); };
+    // Invalid loops (empty, out of the file) are discarded
+    std::optional<LoopPoints> getLoopPoints() const;
+    inline std::string const& getName() const noexcept { return _name; };
+
+private:
+    std::unique_ptr<Decoder> _decoder;
+    std::string const _name;
+    std::string const _extension;
+    uint64_t _frames{ 0 };
+    double _seconds{ 0. };
+};
+
+// Returns the 16 bits OpenAL format matching given channel count
+ALenum getFormat(int channels);
+
+// Opens file with the fastest backend able to decode it.
+// Backends without stats for the extension are tried first, to get measured.
+std::unique_ptr<DecoderHandle> openDecoder(std::string const& filename);
+
+INTERNAL_END;
+
+SSS_AUDIO_END;
+
+#endif // SSS_AUDIO_DECODER_HPP
\ No newline at end of file
@@ -0,0 +1,159 @@
+#ifndef SSS_AUDIO_EFFECT_HPP
+#define SSS_AUDIO_EFFECT_HPP
+
+#include "Engine.hpp"
+#include <AL/efx.h>
+
+SSS_AUDIO_BEGIN;
+
+class Source; // Pre-declaration
+
+enum class ReverbPreset {
+    Generic,
+    Room,
+    Bathroom,
+    LivingRoom,
+    StoneRoom,
+    Auditorium,
+    ConcertHall,
+    Cave,
+    Arena,
+    Hangar,
+    Hallway,
+    Alley,
+    Forest,
+    City,
+    Mountains,
+    Underwater,
+};
+
+// Direct or send path filter, used for occlusion & obstruction
+struct Filter {
+    enum class Type {
+        None,
+        LowPass,
+        HighPass,
+        BandPass,
+    };
+    Type type{ Type::None };
+    float gain{ 1.f };
+    float gain_hf{ 1.f };   // LowPass & BandPass
+    float gain_lf{ 1.f };   // HighPass & BandPass
+};
+
+// Reverb applied to an EffectSlot when the listener is within range.
+// Weight is 1 inside radius, fading to 0 across blend distance.
+struct ReverbZone {
+    std::array<float, 3> position{ 0.f, 0.f, 0.f };
+    float radius{ 10.f };
+    float blend{ 5.f };
+    ReverbPreset preset{ ReverbPreset::Generic };
+};
+
+INTERNAL_BEGIN;
+class Device; // Pre-declaration
+
+// EFX entry points, loaded once the device exists
+struct EFXFunctions {
+    LPALGENEFFECTS GenEffects;
+    LPALDELETEEFFECTS DeleteEffects;
+    LPALEFFECTI Effecti;
+    LPALEFFECTF Effectf;
+    LPALEFFECTFV Effectfv;
+    LPALGENFILTERS GenFilters;
+    LPALDELETEFILTERS DeleteFilters;
+    LPALFILTERI Filteri;
+    LPALFILTERF Filterf;
+    LPALGENAUXILIARYEFFECTSLOTS GenAuxiliaryEffectSlots;
+    LPALDELETEAUXILIARYEFFECTSLOTS DeleteAuxiliaryEffectSlots;
+    LPALAUXILIARYEFFECTSLOTI AuxiliaryEffectSloti;
+    LPALAUXILIARYEFFECTSLOTF AuxiliaryEffectSlotf;
+    bool eax_reverb;
+};
+// Loads EFX entry points of given device, its main context being current
+std::optional<EFXFunctions> loadEFX(ALCdevice* device) noexcept;
+// Returns nullptr if EFX isn't supported by the current device.
+// Loaded along with each main context, reset when the device closes.
+EFXFunctions const* getEFX() noexcept;
+// Generates filter if needed, returns the name to attach to a Source
+ALuint makeFilter(ALuint& id, Filter const& filter);
+void deleteFilter(ALuint& id) noexcept;
+// Flushes dirty EffectSlots in one deferred batch, called by engine ticks
+void updateEffects();
+INTERNAL_END;
+
+// Ignore warning about STL exports as they're private members
+#pragma warning(push, 2)
+#pragma warning(disable: 4251)
+#pragma warning(disable: 4275)
+
+// Shared auxiliary effect slot, which any number of Sources can send to.
+// Parameter changes are batched & applied during engine ticks when the
+// audio thread runs, immediately otherwise.
+class SSS_AUDIO_API EffectSlot final : public Base {
+    friend Source;
+    friend _internal::Device;
+    friend void _internal::updateEffects();
+
+public:
+    EffectSlot(const EffectSlot&)             = delete; // Copy constructor
+    EffectSlot(EffectSlot&&)                  = delete; // Move constructor
+    EffectSlot& operator=(const EffectSlot&)  = delete; // Copy assignment
+    EffectSlot& operator=(EffectSlot&&)       = delete; // Move assignment
+    ~EffectSlot();
+
+    static EffectSlot& create(uint32_t id);
+    static EffectSlot& create();
+    static EffectSlot* get(uint32_t id) noexcept;
+    static void remove(uint32_t id);
+
+    inline static auto const& getMap() noexcept { return _instances; };
+    static void clearAll() noexcept;
+
+    void setReverb(ReverbPreset preset);
+    void setReverb(EFXEAXREVERBPROPERTIES const& properties);
+    // Removes the effect, Sources sending here then output nothing more
+    void clearEffect();
+
+    void setGain(float gain);
+    inline float getGain() const noexcept { return _gain; };
+
+    // Zones are blended by listener distance into this slot's reverb
+    uint32_t addZone(ReverbZone const& zone);
+    void removeZone(uint32_t zone_id);
+    void clearZones();
+
+    inline uint32_t getID() const noexcept { return _map_id; };
+
+private:
+    EffectSlot(uint32_t id);
+
+    // Blends zones from the listener position, if any
+    void _blendZones();
+    void _flush();
+    void _markDirty();
+
+    // Device migration: frees OpenAL objects, then regenerates them
+    static void _suspendAll();
+    static void _resumeAll();
+
+    static std::map<uint32_t, std::unique_ptr<EffectSlot>> _instances;
+
+    ALuint _openal_slot{ 0 };
+    ALuint _openal_effect{ 0 };
+    uint32_t const _map_id;
+
+    bool _has_reverb{ false };
+    EFXEAXREVERBPROPERTIES _reverb{};
+    float _gain{ 1.f };
+    // Gain scale from zones, 0 when out of every zone
+    float _zone_weight{ 1.f };
+    std::map<uint32_t, ReverbZone> _zones;
+    bool _dirty{ false };
+};
+
+#pragma warning(pop)
+
+SSS_AUDIO_END;
+
+#endif // SSS_AUDIO_EFFECT_HPP
\ No newline at end of file
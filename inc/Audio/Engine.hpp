@@ -0,0 +1,56 @@
+#ifndef SSS_AUDIO_ENGINE_HPP
+#define SSS_AUDIO_ENGINE_HPP
+
+#include "_includes.hpp"
+
+SSS_AUDIO_BEGIN;
+
+// Settings of the optional audio thread
+struct EngineSettings {
+    // Time between two ticks
+    std::chrono::microseconds tick_period{ 5000 };
+    // Time a tick may spend on deferred tasks (end callbacks). Engine phases
+    // (streaming, automation, buses, effects) always run in full.
+    std::chrono::microseconds tick_budget{ 2000 };
+    // -2 (lowest) to 2 (time critical), 0 being the OS default.
+    // Outside Windows, positive values request real-time scheduling
+    // (usually privileged) and negative ones a higher niceness.
+    int priority{ 0 };
+    // Bitmask of allowed CPU cores, 0 leaves the thread unpinned
+    uint64_t affinity_mask{ 0 };
+};
+
+// Durations of the ticks run so far, in milliseconds
+struct TickStats {
+    uint64_t count{ 0 };
+    uint64_t overruns{ 0 };     // Ticks which exceeded their budget
+    double last_ms{ 0. };
+    double average_ms{ 0. };
+    double max_ms{ 0. };
+};
+
+// Starts a dedicated thread calling update() every tick_period
+SSS_AUDIO_API void startThread(EngineSettings const& settings = EngineSettings());
+SSS_AUDIO_API void stopThread();
+SSS_AUDIO_API bool isThreadRunning() noexcept;
+
+// Runs a single tick on the calling thread.
+// Should be called regularly when the audio thread isn't running.
+SSS_AUDIO_API void update();
+
+SSS_AUDIO_API TickStats getTickStats() noexcept;
+SSS_AUDIO_API void resetTickStats() noexcept;
+
+INTERNAL_BEGIN;
+// Runs every engine phase once, spending at most budget on deferrable work
+void tick(std::chrono::microseconds budget);
+// Guards Source & Buffer registries against the audio thread
+std::recursive_mutex& getMutex() noexcept;
+// Queues work (such as end callbacks) to be run during the next ticks,
+// within their time budget
+void defer(std::function<void()> task);
+INTERNAL_END;
+
+SSS_AUDIO_END;
+
+#endif // SSS_AUDIO_ENGINE_HPP
\ No newline at end of file
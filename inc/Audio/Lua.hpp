@@ -6,6 +6,10 @@
 #include <sol/sol.hpp>
 #include "Source.hpp"
 #include "Buffer.hpp"
+#include "Bus.hpp"
+#include "Effect.hpp"
+#include "Analyzer.hpp"
+#include "Trace.hpp"
 
 SSS_AUDIO_BEGIN;
 
@@ -16,6 +20,24 @@ inline void lua_setup_Audio(sol::state& lua) try
     audio["init"] = &init;
     audio["terminate"] = &terminate;
 
+    // Engine
+    audio["startThread"] = []() { startThread(); };
+    audio["stopThread"] = &stopThread;
+    audio["isThreadRunning"] = &isThreadRunning;
+    audio["update"] = &update;
+
+    // Automation
+    audio.new_enum<Curve>("Curve", {
+        { "Linear", Curve::Linear },
+        { "Exponential", Curve::Exponential },
+        { "SCurve", Curve::SCurve },
+        { "EqualPower", Curve::EqualPower }
+    });
+    audio["crossfade"] = sol::overload(
+        [](uint32_t from, uint32_t to, float seconds) { crossfade(from, to, seconds); },
+        &crossfade
+    );
+
     // Buffer
     auto buffer = audio.new_usertype<Buffer>("Buffer", sol::factories(
         sol::resolve<Buffer& (uint32_t)>(Buffer::create),
@@ -27,6 +49,31 @@ inline void lua_setup_Audio(sol::state& lua) try
     buffer["loadFile"] = &Buffer::loadFile;
     buffer["getProperty"] = &Buffer::getProperty;
     buffer["id"] = sol::property(&Buffer::getID);
+    // Compression, applied on the next loadFile
+    audio.new_enum<Compression::Format>("Compression", {
+        { "PCM16", Compression::Format::PCM16 },
+        { "IMA4", Compression::Format::IMA4 },
+        { "MSADPCM", Compression::Format::MSADPCM }
+    });
+    buffer["setCompression"] = [](Buffer& self, Compression::Format format, sol::optional<int> block_frames) {
+        self.setCompression({ format, block_frames.value_or(0) });
+    };
+    buffer["setLoopPoints"] = [](Buffer& self, int64_t start, int64_t end) {
+        self.setLoopPoints(LoopPoints{ start, end });
+    };
+    buffer["clearLoopPoints"] = [](Buffer& self) { self.setLoopPoints(std::nullopt); };
+    buffer["bytes"] = sol::property([](Buffer const& self) { return self.getMemory().stored_bytes; });
+    audio["setDefaultCompression"] = [](Compression::Format format, sol::optional<int> block_frames) {
+        Buffer::setDefaultCompression({ format, block_frames.value_or(0) });
+    };
+    audio["getBufferMemory"] = [](sol::this_state state) {
+        BufferMemory const memory = Buffer::getTotalMemory();
+        return sol::state_view(state).create_table_with(
+            "pcm_bytes", memory.pcm_bytes,
+            "stored_bytes", memory.stored_bytes,
+            "saved_bytes", memory.saved()
+        );
+    };
     // Static functions
     audio["getBuffer"] = &Buffer::get;
     audio["removeBuffer"] = &Buffer::remove;
@@ -42,6 +89,15 @@ inline void lua_setup_Audio(sol::state& lua) try
     source["useBuffer"] = &Source::useBuffer;
     source["queueBuffers"] = &Source::queueBuffers;
     source["detachBuffers"] = &Source::detachBuffers;
+    source["streamFile"] = &Source::streamFile;
+    source["is_streaming"] = sol::property(&Source::isStreaming);
+    source["streamCapture"] = &Source::streamCapture;
+    source["setStreamLoopPoints"] = [](Source& self, int64_t start, int64_t end) {
+        self.setStreamLoopPoints(LoopPoints{ start, end });
+    };
+    source["setAnalyzer"] = [](Source& self, sol::optional<uint32_t> analyzer_id) {
+        self.setAnalyzer(analyzer_id ? std::optional<uint32_t>(*analyzer_id) : std::nullopt);
+    };
     // Commands
     source["play"] = &Source::play;
     source["pause"] = &Source::pause;
@@ -53,18 +109,362 @@ inline void lua_setup_Audio(sol::state& lua) try
     // Options
     source["volume"] = sol::property(&Source::getVolume, &Source::setVolume);
     source["loop"] = sol::property(&Source::isLooping, &Source::setLooping);
+    source["gain"] = sol::property(&Source::getGain, &Source::setGain);
+    // Automation, one call per fade
+    source["fade"] = [](Source& self, float target, float seconds, sol::optional<Curve> curve) {
+        self.fadeGain(target, seconds, curve.value_or(Curve::Linear));
+    };
+    source["rampPitch"] = [](Source& self, float target, float seconds, sol::optional<Curve> curve) {
+        self.rampPitch(target, seconds, curve.value_or(Curve::Linear));
+    };
+    source["moveTo"] = [](Source& self, float x, float y, float z, float seconds, sol::optional<Curve> curve) {
+        self.moveTo(x, y, z, seconds, curve.value_or(Curve::Linear));
+    };
+    // Envelope points are given as a flat { time, value, time, value, ... } table
+    source["envelope"] = [](Source& self, std::vector<float> const& flat, sol::optional<Curve> curve) {
+        std::vector<EnvelopePoint> points;
+        points.reserve(flat.size() / 2);
+        for (size_t i = 0; i + 1 < flat.size(); i += 2) {
+            points.push_back({ flat[i], flat[i + 1] });
+        }
+        self.setGainEnvelope(points, curve.value_or(Curve::Linear));
+    };
+    source["stopAutomation"] = &Source::stopAutomation;
+    source["bus"] = sol::property(&Source::getBus, &Source::setBus);
+    // Effects
+    source["setLowPass"] = [](Source& self, float gain, float gain_hf) {
+        self.setDirectFilter({ Filter::Type::LowPass, gain, gain_hf, 1.f });
+    };
+    source["clearFilter"] = [](Source& self) { self.setDirectFilter(Filter()); };
+    source["sendTo"] = [](Source& self, uint32_t slot_id, sol::optional<ALint> send) {
+        self.sendTo(slot_id, send.value_or(0));
+    };
+    source["clearSend"] = [](Source& self, sol::optional<ALint> send) {
+        self.clearSend(send.value_or(0));
+    };
+    source["context"] = sol::property(&Source::getContext, &Source::setContext);
     source["id"] = sol::property(&Source::getID);
+    source["latency"] = sol::property(&Source::getLatency);
     // Static functions
     audio["getSource"] = &Source::get;
     audio["removeSource"] = &Source::remove;
     audio["clearAllSources"] = &Source::clearAll;
 
+    // Integer handles, skipping usertype resolution for per-frame scripts.
+    // Unknown ids are ignored, getters then returning false or 0.
+    audio["play"] = [](uint32_t id) { if (Source* s = Source::get(id)) s->play(); };
+    audio["pause"] = [](uint32_t id) { if (Source* s = Source::get(id)) s->pause(); };
+    audio["stop"] = [](uint32_t id) { if (Source* s = Source::get(id)) s->stop(); };
+    audio["isPlaying"] = [](uint32_t id) {
+        Source const* s = Source::get(id);
+        return s ? s->isPlaying() : false;
+    };
+    audio["setGain"] = [](uint32_t id, float gain) { if (Source* s = Source::get(id)) s->setGain(gain); };
+    audio["getGain"] = [](uint32_t id) {
+        Source const* s = Source::get(id);
+        return s ? s->getGain() : 0.f;
+    };
+    audio["setPitch"] = [](uint32_t id, float pitch) {
+        if (Source* s = Source::get(id)) s->setPropertyFloat(AL_PITCH, pitch);
+    };
+    audio["getPitch"] = [](uint32_t id) {
+        Source const* s = Source::get(id);
+        return s ? s->getPropertyFloat(AL_PITCH) : 0.f;
+    };
+    audio["setPosition"] = [](uint32_t id, float x, float y, float z) {
+        Source::setValues({ { id, SourceParam::X, x }, { id, SourceParam::Y, y }, { id, SourceParam::Z, z } });
+    };
+
+    // Bulk access, one call for any number of Sources
+    audio.new_enum<SourceParam>("Param", {
+        { "Gain", SourceParam::Gain },
+        { "Pitch", SourceParam::Pitch },
+        { "Looping", SourceParam::Looping },
+        { "X", SourceParam::X },
+        { "Y", SourceParam::Y },
+        { "Z", SourceParam::Z },
+        { "Offset", SourceParam::Offset },
+        { "Playing", SourceParam::Playing }
+    });
+    // Flat { id, param, value, id, param, value, ... } table
+    audio["setValues"] = [](sol::table flat) {
+        static thread_local std::vector<SourceValue> values;
+        values.clear();
+        size_t const size = flat.size();
+        for (size_t i = 1; i + 2 <= size; i += 3) {
+            values.push_back({ flat.raw_get<uint32_t>(i),
+                static_cast<SourceParam>(flat.raw_get<uint32_t>(i + 1)), flat.raw_get<float>(i + 2) });
+        }
+        Source::setValues(values);
+    };
+    // Flat { id, param, id, param, ... } table, values are written to
+    // given table (reused across frames) or to a new one, which is returned
+    audio["getValues"] = [](sol::this_state state, sol::table flat, sol::optional<sol::table> out) {
+        static thread_local std::vector<SourceValue> values;
+        values.clear();
+        size_t const size = flat.size();
+        for (size_t i = 1; i + 1 <= size; i += 2) {
+            values.push_back({ flat.raw_get<uint32_t>(i),
+                static_cast<SourceParam>(flat.raw_get<uint32_t>(i + 1)), 0.f });
+        }
+        Source::getValues(values);
+        sol::table results = out ? *out : sol::state_view(state).create_table(static_cast<int>(values.size()));
+        for (size_t i = 0; i < values.size(); ++i) {
+            results.raw_set(i + 1, values[i].value);
+        }
+        return results;
+    };
+
+    // Bus
+    auto bus = audio.new_usertype<Bus>("Bus", sol::factories(
+        sol::resolve<Bus& (std::string const&, std::string const&)>(Bus::create),
+        [](std::string const& name) -> Bus& { return Bus::create(name); }),
+        sol::base_classes, sol::bases<Base>()
+    );
+    bus["name"] = sol::property(&Bus::getName);
+    bus["parent"] = sol::property(&Bus::getParent, &Bus::setParent);
+    bus["gain"] = sol::property(&Bus::getGain, &Bus::setGain);
+    bus["muted"] = sol::property(&Bus::isMuted, &Bus::setMuted);
+    bus["paused"] = sol::property(&Bus::isPaused, &Bus::setPaused);
+    bus["duckUnder"] = sol::overload(
+        [](Bus& self, std::string const& trigger, float gain) { self.duckUnder(trigger, gain); },
+        &Bus::duckUnder
+    );
+    bus["stopDucking"] = &Bus::stopDucking;
+    bus["setEffectSlot"] = &Bus::setEffectSlot;
+    bus["clearEffectSlot"] = &Bus::clearEffectSlot;
+    // Static functions
+    audio["getBus"] = &Bus::get;
+    audio["removeBus"] = &Bus::remove;
+    audio["clearAllBuses"] = &Bus::clearAll;
+
+    // EffectSlot
+    audio.new_enum<ReverbPreset>("ReverbPreset", {
+        { "Generic", ReverbPreset::Generic },
+        { "Room", ReverbPreset::Room },
+        { "Bathroom", ReverbPreset::Bathroom },
+        { "LivingRoom", ReverbPreset::LivingRoom },
+        { "StoneRoom", ReverbPreset::StoneRoom },
+        { "Auditorium", ReverbPreset::Auditorium },
+        { "ConcertHall", ReverbPreset::ConcertHall },
+        { "Cave", ReverbPreset::Cave },
+        { "Arena", ReverbPreset::Arena },
+        { "Hangar", ReverbPreset::Hangar },
+        { "Hallway", ReverbPreset::Hallway },
+        { "Alley", ReverbPreset::Alley },
+        { "Forest", ReverbPreset::Forest },
+        { "City", ReverbPreset::City },
+        { "Mountains", ReverbPreset::Mountains },
+        { "Underwater", ReverbPreset::Underwater }
+    });
+    auto slot = audio.new_usertype<EffectSlot>("EffectSlot", sol::factories(
+        sol::resolve<EffectSlot& (uint32_t)>(EffectSlot::create),
+        sol::resolve<EffectSlot& ()>(EffectSlot::create)),
+        sol::base_classes, sol::bases<Base>()
+    );
+    slot["setReverb"] = sol::resolve<void(ReverbPreset)>(&EffectSlot::setReverb);
+    slot["clearEffect"] = &EffectSlot::clearEffect;
+    slot["gain"] = sol::property(&EffectSlot::getGain, &EffectSlot::setGain);
+    slot["addZone"] = [](EffectSlot& self, float x, float y, float z, float radius, float blend, ReverbPreset preset) {
+        return self.addZone({ { x, y, z }, radius, blend, preset });
+    };
+    slot["removeZone"] = &EffectSlot::removeZone;
+    slot["clearZones"] = &EffectSlot::clearZones;
+    slot["id"] = sol::property(&EffectSlot::getID);
+    // Static functions
+    audio["getEffectSlot"] = &EffectSlot::get;
+    audio["removeEffectSlot"] = &EffectSlot::remove;
+    audio["clearAllEffectSlots"] = &EffectSlot::clearAll;
+
+    // Capture
+    auto capture = audio.new_usertype<Capture>("Capture", sol::factories(
+        [](sol::optional<sol::table> table) -> Capture& {
+            CaptureSettings settings;
+            if (table) {
+                settings.device = table->get_or("device", settings.device);
+                settings.frequency = table->get_or("frequency", settings.frequency);
+                settings.channels = table->get_or("channels", settings.channels);
+                settings.period_frames = table->get_or("period_frames", settings.period_frames);
+                settings.buffer_frames = table->get_or("buffer_frames", settings.buffer_frames);
+            }
+            return Capture::create(settings);
+        }),
+        sol::base_classes, sol::bases<Base>()
+    );
+    capture["start"] = &Capture::start;
+    capture["stop"] = &Capture::stop;
+    capture["flush"] = &Capture::flush;
+    capture["is_running"] = sol::property(&Capture::isRunning);
+    capture["overruns"] = sol::property(&Capture::getOverruns);
+    capture["id"] = sol::property(&Capture::getID);
+    // Static functions
+    audio["getCapture"] = &Capture::get;
+    audio["removeCapture"] = &Capture::remove;
+    audio["clearAllCaptures"] = &Capture::clearAll;
+    audio["getCaptureDevices"] = &Capture::getDevices;
+
+    // Analyzer
+    auto analyzer = audio.new_usertype<Analyzer>("Analyzer", sol::factories(
+        [](sol::optional<sol::table> table) -> Analyzer& {
+            AnalyzerSettings settings;
+            if (table) {
+                settings.fft_size = table->get_or("fft_size", settings.fft_size);
+                settings.block_frames = table->get_or("block_frames", settings.block_frames);
+                settings.buffer_frames = table->get_or("buffer_frames", settings.buffer_frames);
+            }
+            return Analyzer::create(settings);
+        }),
+        sol::base_classes, sol::bases<Base>()
+    );
+    // Latest meters, as a table
+    analyzer["getResult"] = [](Analyzer& self, sol::this_state state) {
+        AnalysisResult const& result = self.getResult();
+        return sol::state_view(state).create_table_with(
+            "blocks", result.blocks,
+            "peak", result.peak,
+            "rms", result.rms,
+            "momentary_lufs", result.momentary_lufs,
+            "short_term_lufs", result.short_term_lufs,
+            "integrated_lufs", result.integrated_lufs
+        );
+    };
+    // Spectrum in dBFS, filling given table if any to avoid allocations
+    analyzer["getSpectrum"] = [](Analyzer& self, sol::this_state state, sol::optional<sol::table> out) {
+        std::vector<float> const& spectrum = self.getResult().spectrum;
+        sol::table results = out ? *out : sol::state_view(state).create_table(static_cast<int>(spectrum.size()));
+        for (size_t i = 0; i < spectrum.size(); ++i) {
+            results.raw_set(i + 1, spectrum[i]);
+        }
+        return results;
+    };
+    analyzer["resetLoudness"] = &Analyzer::resetLoudness;
+    analyzer["dropped"] = sol::property(&Analyzer::getDropped);
+    analyzer["id"] = sol::property(&Analyzer::getID);
+    // Static functions
+    audio["getAnalyzer"] = &Analyzer::get;
+    audio["removeAnalyzer"] = &Analyzer::remove;
+    audio["clearAllAnalyzers"] = &Analyzer::clearAll;
+    audio["setMixAnalyzer"] = [](sol::optional<uint32_t> analyzer_id) {
+        setMixAnalyzer(analyzer_id ? std::optional<uint32_t>(*analyzer_id) : std::nullopt);
+    };
+
+    // Decoders
+    audio["getDecoders"] = &getDecoders;
+    audio["benchmarkDecoders"] = [](sol::this_state state, std::string const& filename, sol::optional<int> runs) {
+        sol::state_view lua(state);
+        sol::table results = lua.create_table();
+        for (DecoderBenchmark const& bench : benchmarkDecoders(filename, runs.value_or(3))) {
+            results.add(lua.create_table_with(
+                "name", bench.name,
+                "supported", bench.supported,
+                "runs", bench.runs,
+                "decode_ms", bench.decode_ms,
+                "realtime_factor", bench.realtime_factor
+            ));
+        }
+        return results;
+    };
+
     // Global properties
     audio["getVolume"] = &getMainVolume;
     audio["setVolume"] = &setMainVolume;
     audio["getDevice"] = &getCurrentDevice,
     audio["setDevice"] = &selectDevice;
     audio["getAllDevices"] = &getDevices;
+    // Listener contexts
+    audio["createContext"] = &createContext;
+    audio["removeContext"] = &removeContext;
+    audio["getContexts"] = &getContexts;
+    audio["setListenerGain"] = &setListenerGain;
+    audio["setListenerPosition"] = &setListenerPosition;
+    audio["setListenerOrientation"] = [](uint32_t context_id,
+        float at_x, float at_y, float at_z, float up_x, float up_y, float up_z)
+    {
+        setListenerOrientation(context_id, { at_x, at_y, at_z }, { up_x, up_y, up_z });
+    };
+    audio.new_enum<DeviceSettings::OutputMode>("OutputMode", {
+        { "Any", DeviceSettings::OutputMode::Any },
+        { "Mono", DeviceSettings::OutputMode::Mono },
+        { "Stereo", DeviceSettings::OutputMode::Stereo },
+        { "StereoBasic", DeviceSettings::OutputMode::StereoBasic },
+        { "StereoUHJ", DeviceSettings::OutputMode::StereoUHJ },
+        { "StereoHRTF", DeviceSettings::OutputMode::StereoHRTF },
+        { "Quad", DeviceSettings::OutputMode::Quad },
+        { "Surround51", DeviceSettings::OutputMode::Surround51 },
+        { "Surround61", DeviceSettings::OutputMode::Surround61 },
+        { "Surround71", DeviceSettings::OutputMode::Surround71 }
+    });
+    // Missing keys keep their current value
+    audio["configureDevice"] = [](sol::table settings) {
+        DeviceSettings config = getDeviceSettings();
+        config.frequency = settings.get_or("frequency", config.frequency);
+        config.period_size = settings.get_or("period_size", config.period_size);
+        config.refresh = settings.get_or("refresh", config.refresh);
+        config.mono_sources = settings.get_or("mono_sources", config.mono_sources);
+        config.stereo_sources = settings.get_or("stereo_sources", config.stereo_sources);
+        config.max_sends = settings.get_or("max_sends", config.max_sends);
+        config.output_mode = settings.get_or("output_mode", config.output_mode);
+        config.loopback = settings.get_or("loopback", config.loopback);
+        configureDevice(config);
+    };
+    audio["getDeviceInfo"] = [](sol::this_state state) {
+        DeviceInfo const info = getDeviceInfo();
+        return sol::state_view(state).create_table_with(
+            "frequency", info.frequency,
+            "refresh", info.refresh,
+            "mono_sources", info.mono_sources,
+            "stereo_sources", info.stereo_sources,
+            "max_sends", info.max_sends,
+            "latency_ms", info.latency_ms,
+            "switch_ms", info.switch_ms,
+            "loopback", info.loopback
+        );
+    };
+    audio["getInitStats"] = [](sol::this_state state) {
+        InitStats const stats = getInitStats();
+        return sol::state_view(state).create_table_with(
+            "open_ms", stats.open_ms,
+            "context_ms", stats.context_ms,
+            "upload_ms", stats.upload_ms,
+            "total_ms", stats.total_ms,
+            "enumerate_ms", stats.enumerate_ms,
+            "enumerated", stats.enumerated
+        );
+    };
+
+    // Call traces
+    audio["startRecording"] = &startRecording;
+    audio["stopRecording"] = &stopRecording;
+    audio["isRecording"] = &isRecording;
+    audio["replayTrace"] = [](sol::this_state state, std::string const& filename, sol::optional<bool> render) {
+        ReplaySettings settings;
+        settings.render = render.value_or(settings.render);
+        ReplayStats const stats = replayTrace(filename, settings);
+        sol::state_view lua(state);
+        sol::table ops = lua.create_table();
+        for (TraceOpStats const& op : stats.ops) {
+            ops[op.name] = lua.create_table_with(
+                "count", op.count,
+                "total_us", op.total_us,
+                "max_us", op.max_us,
+                "allocations", op.allocations
+            );
+        }
+        return lua.create_table_with(
+            "events", stats.events,
+            "skipped", stats.skipped,
+            "trace_ms", stats.trace_ms,
+            "wall_ms", stats.wall_ms,
+            "calls_ms", stats.calls_ms,
+            "render_ms", stats.render_ms,
+            "update_ms", stats.update_ms,
+            "speedup", stats.speedup(),
+            "counts_allocations", stats.counts_allocations,
+            "allocations", stats.allocations,
+            "allocated_bytes", stats.allocated_bytes,
+            "ops", ops
+        );
+    };
 }
 CATCH_AND_RETHROW_FUNC_EXC;
 
@@ -1,14 +1,40 @@
 #ifndef SSS_AUDIO_SOURCE_HPP
 #define SSS_AUDIO_SOURCE_HPP
 
-#include "_includes.hpp"
+#include "Automation.hpp"
+#include "Bus.hpp"
+#include "Effect.hpp"
+#include "Decoder.hpp"
+#include "Capture.hpp"
 
 SSS_AUDIO_BEGIN;
 
 INTERNAL_BEGIN
 class Device; // Pre-declaration
+struct Stream; // Pre-declaration
+struct SourceSnapshot; // Pre-declaration
 INTERNAL_END
 class SSS_AUDIO_API Buffer;
+class SSS_AUDIO_API Bus;
+class SSS_AUDIO_API EffectSlot;
+
+// Parameters for bulk access, see Source::setValues() & getValues()
+enum class SourceParam : uint32_t {
+    Gain,
+    Pitch,
+    Looping,    // 0 or 1
+    X,          // Position
+    Y,
+    Z,
+    Offset,     // Playback position, in seconds
+    Playing,    // Setting 1 plays, 0 pauses
+};
+
+struct SourceValue {
+    uint32_t id;
+    SourceParam param;
+    float value;
+};
 
 // Ignore warning about STL exports as they're private members
 #pragma warning(push, 2)
@@ -18,6 +44,11 @@ class SSS_AUDIO_API Buffer;
 class SSS_AUDIO_API Source final : public Base {
     friend _internal::Device;
     friend Buffer;
+    friend Bus;
+    friend EffectSlot;
+    friend void _internal::updateBuses();
+    friend void _internal::tick(std::chrono::microseconds budget);
+    friend void _internal::updateAutomation();
 
 public:
     Source(const Source&)             = delete; // Copy constructor
@@ -34,11 +65,24 @@ public:
     inline static auto const& getArray() noexcept { return _instances; };
     static void clearAll() noexcept;
 
+    // Applies every value under one lock & one deferred OpenAL batch.
+    // Unknown Source ids are skipped, & read as 0.
+    static void setValues(std::vector<SourceValue> const& values);
+    static void getValues(std::vector<SourceValue>& values);
+
     void useBuffer(uint32_t id);
     void queueBuffers(std::vector<uint32_t> ids);
     void detachBuffers();
     std::vector<uint32_t> getBufferIDs() const noexcept;
 
+    // Decodes file by chunks refilled during engine ticks instead of as a whole.
+    // Replaces any attached Buffer.
+    void streamFile(std::string const& filename);
+    inline bool isStreaming() const noexcept { return !!_stream; };
+    // Streams captured audio (sidetone, loopback tests) with one buffer per
+    // capture period. This Source becomes the Capture's single consumer.
+    void streamCapture(uint32_t capture_id);
+
     void play();
     void pause();
     void stop();
@@ -47,11 +91,43 @@ public:
     bool isPaused() const noexcept;
     bool isStopped() const noexcept;
 
+    // Time until the current sample is heard, in seconds (AL_SOFT_source_latency)
+    double getLatency() const;
+
+    // Called during engine ticks when the source stops playing on its own
+    void setEndCallback(std::function<void(uint32_t)> callback);
+
     void setVolume(int percentage);
     int getVolume() const;
 
+    // Linear gain, 1.f being the original volume
+    void setGain(float gain);
+    float getGain() const noexcept;
+
+    // Automation, evaluated by engine ticks (see startThread() & update()).
+    // Setting a value directly cancels the automation of that value.
+    void fadeGain(float target, float seconds, Curve curve = Curve::Linear);
+    void rampPitch(float target, float seconds, Curve curve = Curve::Linear);
+    void moveTo(float x, float y, float z, float seconds, Curve curve = Curve::Linear);
+    void setGainEnvelope(std::vector<EnvelopePoint> const& points, Curve curve = Curve::Linear);
+    void setPitchEnvelope(std::vector<EnvelopePoint> const& points, Curve curve = Curve::Linear);
+    void stopAutomation();
+
+    // Assigns this Source to a Bus, an empty name meaning no Bus
+    void setBus(std::string const& name);
+    inline std::string const& getBus() const noexcept { return _bus; };
+
+    // EFX: filter applied to the dry signal (occlusion)
+    void setDirectFilter(Filter const& filter);
+    // EFX: routes this Source to a shared EffectSlot on given send
+    void sendTo(uint32_t slot_id, ALint send = 0, Filter const& filter = Filter());
+    void clearSend(ALint send = 0);
+
     void setLooping(bool enable);
     bool isLooping() const;
+    // Streams only, overriding the loop read from the file.
+    // Buffers have their own, see Buffer::setLoopPoints().
+    void setStreamLoopPoints(std::optional<LoopPoints> loop);
 
     ALint getPropertyInt(ALenum param) const;
     void setPropertyInt(ALenum param, ALint value);
@@ -59,24 +135,93 @@ public:
     ALfloat getPropertyFloat(ALenum param) const;
     void setPropertyFloat(ALenum param, ALfloat value);
 
+    // Streams only: feeds each chunk to given Analyzer once it was played,
+    // which lags playback by up to a chunk (~125ms)
+    void setAnalyzer(std::optional<uint32_t> analyzer_id);
+    inline std::optional<uint32_t> getAnalyzer() const noexcept { return _analyzer_id; };
+
+    // Moves this Source to another listener's context (see createContext),
+    // keeping its state. Sources on other contexts than 0 can't use EffectSlots.
+    void setContext(uint32_t context_id);
+    inline uint32_t getContext() const noexcept { return _context_id; };
+
     inline uint32_t getID() const noexcept { return _arr_id; };
 
 private:
     Source(uint32_t id);
 
+    // Makes this Source's context current on the calling thread
+    inline void _bind() const noexcept { _internal::bindContext(_context_id); };
+
     ALint _getType() const noexcept;    // Static, Streaming
     ALint _getState() const noexcept;   // Playing, Paused, Stopped
 
     // Removes buffer from queue
     void _removeBuffer(ALuint id);
 
+    // Polls every source state once, queues end callbacks
+    static void _updateStates();
+
+    // Refills processed stream buffers of every source
+    static void _updateStreams();
+    // Generates stream buffers & queues the first chunks
+    void _startStream(std::unique_ptr<_internal::Stream> stream);
+    // Decodes the next stream chunk into given buffer, false at the end
+    bool _fillStreamBuffer(ALuint buffer);
+    // Seeks stream to given frame and queues its buffers again
+    void _rewindStream(int64_t frame = 0);
+    // Detaches & frees the stream, if any
+    void _endStream();
+
+    // Sends _gain, scaled by the Bus gain, to OpenAL
+    void _applyGain();
+    // Sends to the Bus' EffectSlot on send 0, if any and not used by the user
+    void _applyBusEffectSlot();
+    // Returns the closest paused Bus this Source is within, if any
+    Bus* _getPausingBus() const noexcept;
+
+    // Device migration: snapshots & frees OpenAL objects, then rebuilds them.
+    // Buffers must be suspended after & resumed before Sources.
+    static void _suspendAll();
+    static void _resumeAll();
+    void _suspend();
+    void _resume();
+
     static std::array<std::unique_ptr<Source>, 256U> _instances;
 
-    ALuint const _openal_id;    // OpenAL id
+    ALuint _openal_id;          // OpenAL id, regenerated on device migration
     uint32_t const _arr_id;     // _instances id
+    uint32_t _context_id{ 0 };  // Context the OpenAL source lives in
 
     // OpenAL Buffer ID queue (NOT the ones returned by getBufferIDs)
     std::vector<ALuint> _buffer_ids;
+    // Set while streaming, with its own buffers
+    std::unique_ptr<_internal::Stream> _stream;
+
+    // Gain as set by the user or automation
+    float _gain{ 1.f };
+    // Assigned Bus & its effective gain
+    std::string _bus;
+    float _bus_gain{ 1.f };
+
+    // EFX filters & EffectSlot ids per send
+    ALuint _direct_filter{ 0 };
+    Filter _direct_filter_settings;
+    std::array<std::optional<uint32_t>, 4> _sends;
+    std::array<ALuint, 4> _send_filters{};
+    std::array<Filter, 4> _send_filter_settings;
+    // Whether send 0 was set by the Bus, rather than by the user
+    bool _bus_send{ false };
+
+    // Fed with played stream chunks
+    std::optional<uint32_t> _analyzer_id;
+
+    // Set between _suspendAll & _resumeAll
+    std::unique_ptr<_internal::SourceSnapshot> _snapshot;
+
+    // State as of the last engine tick
+    ALint _last_state{ AL_INITIAL };
+    std::function<void(uint32_t)> _on_end;
 };
 
 #pragma warning(pop)
@@ -0,0 +1,189 @@
+#ifndef SSS_AUDIO_TRACE_HPP
+#define SSS_AUDIO_TRACE_HPP
+
+#include "Engine.hpp"
+#include <atomic>
+#include <span>
+#include <string_view>
+
+SSS_AUDIO_BEGIN;
+
+// Public API calls logged by the recorder. Values are part of the trace
+// format: only append new ones.
+enum class TraceOp : uint8_t {
+    SourceCreate,
+    SourceRemove,
+    SourceUseBuffer,
+    SourceQueueBuffers,
+    SourceDetachBuffers,
+    SourceStreamFile,
+    SourcePlay,
+    SourcePause,
+    SourceStop,
+    SourceSetGain,
+    SourceSetLooping,
+    SourceSetPropertyInt,
+    SourceSetPropertyFloat,
+    SourceSetBus,
+    SourceSetValues,
+    BufferCreate,
+    BufferRemove,
+    BufferLoadFile,
+    SelectDevice,
+    ConfigureDevice,
+    SetMainVolume,
+    BusCreate,
+    BusRemove,
+    BusSetParent,
+    BusSetGain,
+    BusSetMuted,
+    BusSetPaused,
+    BusDuckUnder,
+    BusStopDucking,
+    BusSetEffectSlot,
+    BusClearEffectSlot,
+    SourceFadeGain,
+    SourceRampPitch,
+    SourceMoveTo,
+    SourceSetGainEnvelope,
+    SourceSetPitchEnvelope,
+    SourceStopAutomation,
+    Crossfade,
+    SourceSetDirectFilter,
+    SourceSendTo,
+    SourceClearSend,
+    EffectSlotCreate,
+    EffectSlotRemove,
+    EffectSlotSetReverb,
+    EffectSlotClearEffect,
+    EffectSlotSetGain,
+    EffectSlotAddZone,
+    EffectSlotRemoveZone,
+    EffectSlotClearZones,
+    ContextCreate,
+    ContextRemove,
+    SourceSetContext,
+    SetListenerGain,
+    SetListenerPosition,
+    SetListenerOrientation,
+    Count
+};
+
+// Starts logging every recorded call, timestamped, into given file.
+// Traces are compact binary files meant for replayTrace().
+// Recorded: the TraceOp calls above, on Sources, Buffers, Buses, automation,
+// EffectSlots, filters & sends, contexts & listeners, and the device.
+// Not recorded: custom reverb properties (presets are), Buffer loop points,
+// Captures & Analyzers, including Source::streamCapture() & setAnalyzer().
+SSS_AUDIO_API void startRecording(std::string const& filename);
+SSS_AUDIO_API void stopRecording() noexcept;
+SSS_AUDIO_API bool isRecording() noexcept;
+
+struct ReplaySettings {
+    // Mixes the audio elapsed between calls, as a real device would
+    bool render{ true };
+    // Trace time between two engine ticks, as the audio thread would run them
+    std::chrono::microseconds tick_period{ 5000 };
+};
+
+struct TraceOpStats {
+    std::string name;
+    uint64_t count{ 0 };
+    double total_us{ 0. };
+    double max_us{ 0. };
+    uint64_t allocations{ 0 };
+};
+
+// Allocations are only counted when built with SSS_AUDIO_COUNT_ALLOCATIONS,
+// which replaces the global operator new of the library.
+struct ReplayStats {
+    uint64_t events{ 0 };
+    // Events on Sources or Buffers missing from the trace, as created before
+    // the recording started. Not timed.
+    uint64_t skipped{ 0 };
+    double trace_ms{ 0. };      // Recorded session duration
+    double wall_ms{ 0. };       // Replay duration
+    double calls_ms{ 0. };      // Spent in replayed calls
+    double render_ms{ 0. };     // Spent mixing
+    double update_ms{ 0. };     // Spent in engine ticks
+    bool counts_allocations{ false };
+    uint64_t allocations{ 0 };
+    uint64_t allocated_bytes{ 0 };
+    std::vector<TraceOpStats> ops;  // Recorded ops only
+    inline double speedup() const noexcept { return wall_ms > 0. ? trace_ms / wall_ms : 0.; };
+};
+
+// Replays given trace as fast as possible on a loopback device: init() is
+// called with DeviceSettings::loopback if needed, which must be set when the
+// library is already initialized. Sources & Buffers are cleared beforehand.
+SSS_AUDIO_API ReplayStats replayTrace(std::string const& filename,
+    ReplaySettings const& settings = ReplaySettings());
+
+struct SourceValue; // Pre-declaration
+struct EnvelopePoint; // Pre-declaration
+
+INTERNAL_BEGIN;
+
+// Argument of a recorded call, viewing the caller's data
+struct TraceArg {
+    enum class Type : uint8_t {
+        UInt,
+        Int,
+        Float,
+        String,
+        IDs,
+        Values,
+        Points,
+    };
+    inline TraceArg(uint32_t value) noexcept : type(Type::UInt), u(value) {};
+    inline TraceArg(bool value) noexcept : type(Type::UInt), u(value ? 1 : 0) {};
+    inline TraceArg(int32_t value) noexcept : type(Type::Int), i(value) {};
+    inline TraceArg(float value) noexcept : type(Type::Float), f(value) {};
+    inline TraceArg(std::string_view value) noexcept : type(Type::String), s(value) {};
+    inline TraceArg(std::string const& value) noexcept : type(Type::String), s(value) {};
+    inline TraceArg(std::vector<uint32_t> const& value) noexcept : type(Type::IDs), ids(value) {};
+    inline TraceArg(std::vector<SourceValue> const& value) noexcept : type(Type::Values), values(&value) {};
+    inline TraceArg(std::vector<EnvelopePoint> const& value) noexcept : type(Type::Points), points(&value) {};
+
+    Type type;
+    union {
+        uint64_t u;
+        int64_t i;
+        float f;
+        std::string_view s;
+        std::span<uint32_t const> ids;
+        std::vector<SourceValue> const* values;
+        std::vector<EnvelopePoint> const* points;
+    };
+};
+
+extern std::atomic<bool> recording;
+
+void beginTraceCall(TraceOp op, std::initializer_list<TraceArg> args) noexcept;
+void endTraceCall() noexcept;
+
+// Records a call for its scope. Calls nested within it aren't recorded, as
+// replaying the outer one repeats them. Costs an atomic load when not recording.
+class TraceCall {
+public:
+    template<typename... Args>
+    inline TraceCall(TraceOp op, Args const&... args) noexcept
+        : _active(recording.load(std::memory_order_relaxed))
+    {
+        if (_active) {
+            beginTraceCall(op, { TraceArg(args)... });
+        }
+    }
+    inline ~TraceCall() { if (_active) endTraceCall(); };
+    TraceCall(TraceCall const&) = delete;
+    TraceCall& operator=(TraceCall const&) = delete;
+
+private:
+    bool const _active;
+};
+
+INTERNAL_END;
+
+SSS_AUDIO_END;
+
+#endif // SSS_AUDIO_TRACE_HPP
\ No newline at end of file
@@ -11,6 +11,10 @@
 #include <map>
 #include <unordered_map>
 #include <array>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <optional>
 
 /** Declares the SSS::Audio namespace.
  *  Further code will be nested in the SSS::Audio namespace.\n
@@ -36,20 +40,123 @@
 SSS_AUDIO_BEGIN;
 
 INTERNAL_BEGIN;
+// Contexts on the device, including the main one
+inline constexpr uint32_t max_contexts = 16;
 std::string getALErrorString(ALenum error);
 bool is_init() noexcept;
+// Fails over to the default device on disconnection, called by engine ticks
+void checkDevice();
+// Makes given context current on the calling thread (alcSetThreadContext).
+// Cached per thread, so binding the already bound context costs no ALC call.
+// Callers hold the engine mutex from binding until their AL calls are done:
+// without ALC_EXT_thread_local_context, the binding is process-wide.
+void bindContext(uint32_t context_id) noexcept;
+bool hasContext(uint32_t context_id) noexcept;
+
+// Batches AL state changes per context (AL_SOFT_deferred_updates), applying
+// them at once when destroyed. Needs the engine mutex held throughout.
+class DeferredUpdates {
+public:
+    DeferredUpdates() = default;
+    DeferredUpdates(const DeferredUpdates&) = delete;
+    DeferredUpdates& operator=(const DeferredUpdates&) = delete;
+    ~DeferredUpdates();
+    // Defers updates of given context, which must be bound
+    void add(uint32_t context_id) noexcept;
+private:
+    std::array<bool, max_contexts> _deferred{};
+};
 INTERNAL_END;
 
 SSS_AUDIO_API void init();
 SSS_AUDIO_API void terminate();
 
+// Device configuration, 0 values leaving OpenAL defaults
+struct DeviceSettings {
+    enum class OutputMode {
+        Any,
+        Mono,
+        Stereo,
+        StereoBasic,    // No panning post-process
+        StereoUHJ,
+        StereoHRTF,     // Headphones
+        Quad,
+        Surround51,
+        Surround61,
+        Surround71,
+    };
+    int frequency{ 0 };         // Mixing rate, in Hz
+    int period_size{ 0 };       // Mixing period, in sample frames
+    int refresh{ 0 };           // Mixing updates per second, ignored if period_size is set
+    int mono_sources{ 0 };      // Voice counts
+    int stereo_sources{ 0 };
+    int max_sends{ 0 };         // EFX auxiliary sends per Source
+    OutputMode output_mode{ OutputMode::Any };
+    // Headless device (ALC_SOFT_loopback) mixing 16 bits stereo on renderMix()
+    // calls only, at 48kHz by default. Can only be set before init().
+    bool loopback{ false };
+};
+
+// Effective device values, as reported by OpenAL
+struct DeviceInfo {
+    int frequency{ 0 };
+    int refresh{ 0 };
+    int mono_sources{ 0 };
+    int stereo_sources{ 0 };
+    int max_sends{ 0 };
+    double latency_ms{ 0. };    // Output latency, 0 if unknown
+    double switch_ms{ 0. };     // Duration of the last device switch
+    bool loopback{ false };
+};
+
+// Applied at once to the current device when possible (without recreating
+// Sources & Buffers), otherwise the next time a device is opened
+SSS_AUDIO_API void configureDevice(DeviceSettings const& settings) noexcept;
+SSS_AUDIO_API DeviceSettings getDeviceSettings() noexcept;
+SSS_AUDIO_API DeviceInfo getDeviceInfo() noexcept;
+
+// Time spent in each init() phase. Devices are enumerated in the background
+// once the default one is opened, getDevices() waiting for it if needed.
+struct InitStats {
+    double open_ms{ 0. };       // Default device opening
+    double context_ms{ 0. };    // Context creation
+    double upload_ms{ 0. };     // Buffers loaded before init()
+    double total_ms{ 0. };
+    double enumerate_ms{ 0. };  // Background device enumeration
+    bool enumerated{ false };
+};
+// Doesn't call init(), returning zeroes if it wasn't
+SSS_AUDIO_API InitStats getInitStats() noexcept;
+
 SSS_AUDIO_API std::vector<std::string> getDevices() noexcept;
 SSS_AUDIO_API std::string getCurrentDevice() noexcept;
 SSS_AUDIO_API void selectDevice(std::string const& name) noexcept;
 
+// Loopback devices only: mixes the next frames into given interleaved
+// stereo samples, returning false otherwise. When the audio thread isn't
+// running, update() must be called in between to keep streams fed.
+SSS_AUDIO_API bool renderMix(short* samples, size_t frames) noexcept;
+// Feeds every rendered mix to given Analyzer, nullopt to stop
+SSS_AUDIO_API void setMixAnalyzer(std::optional<uint32_t> analyzer_id) noexcept;
+
 SSS_AUDIO_API void setMainVolume(int volume) noexcept;
 SSS_AUDIO_API int getMainVolume() noexcept;
 
+// Additional contexts on the current device (split-screen, tool previews),
+// each with its own listener & mix. Context 0 is the main one.
+// Buffers are shared, EffectSlots only exist on the main context.
+// Throws if the device lacks ALC_EXT_thread_local_context.
+SSS_AUDIO_API uint32_t createContext();
+// Also removes the Sources bound to it
+SSS_AUDIO_API void removeContext(uint32_t context_id) noexcept;
+SSS_AUDIO_API std::vector<uint32_t> getContexts() noexcept;
+
+SSS_AUDIO_API void setListenerGain(uint32_t context_id, float gain) noexcept;
+SSS_AUDIO_API void setListenerPosition(uint32_t context_id, float x, float y, float z) noexcept;
+// Forward & up vectors
+SSS_AUDIO_API void setListenerOrientation(uint32_t context_id,
+    std::array<float, 3> const& at, std::array<float, 3> const& up) noexcept;
+
 SSS_AUDIO_END;
 
  /** Holds all SSS::Audio related log flags.*/
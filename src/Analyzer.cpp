@@ -0,0 +1,497 @@
+#include "Audio/Analyzer.hpp"
+
+#include <cmath>
+
+SSS_AUDIO_BEGIN;
+
+INTERNAL_BEGIN;
+
+static constexpr double _pi = 3.14159265358979323846;
+
+// Integrated loudness histogram, 0.1 LU bins from the absolute gate
+static constexpr double _gate_lufs = -70.;
+static constexpr size_t _histogram_bins = 800;
+
+struct Biquad {
+    double b0, b1, b2, a1, a2;
+};
+
+// Everything the analysis thread works with, allocated once the format is known
+struct AnalysisState {
+    int channels{ 0 };
+    int sample_rate{ 0 };
+
+    // Input block, interleaved
+    std::vector<short> input;
+    std::vector<float> samples;
+
+    // FFT: split real & imaginary arrays, twiddles stored contiguously per
+    // stage (at half - 1), so that butterfly loops vectorize
+    size_t fft_size{ 0 };
+    std::vector<float> history;     // Last fft_size mono frames
+    std::vector<float> window;
+    std::vector<uint32_t> bit_reverse;
+    std::vector<float> twiddle_re;
+    std::vector<float> twiddle_im;
+    std::vector<float> re;
+    std::vector<float> im;
+    float spectrum_scale{ 1.f };
+
+    // K-weighting (pre-filter & RLB high-pass), x1, x2, y1, y2 per stage & channel
+    std::array<Biquad, 2> k_weighting{};
+    std::vector<std::array<double, 8>> k_states;
+    // 100ms gating sub-blocks, the last 30 kept for short-term loudness
+    size_t sub_length{ 0 };
+    size_t sub_frames{ 0 };
+    double sub_sum{ 0. };
+    std::array<double, 30> subs{};
+    uint64_t sub_count{ 0 };
+    // 400ms block powers above the absolute gate
+    std::array<uint64_t, _histogram_bins> gated_counts{};
+    std::array<double, _histogram_bins> gated_powers{};
+    float integrated_lufs{ -std::numeric_limits<float>::infinity() };
+    uint64_t blocks{ 0 };
+};
+
+static float _toLUFS(double power) noexcept
+{
+    return power > 0. ? static_cast<float>(-0.691 + 10. * std::log10(power))
+        : -std::numeric_limits<float>::infinity();
+}
+
+
+// BS.1770 filters for any sample rate (coefficients as derived by libebur128)
+static std::array<Biquad, 2> _getKWeighting(int sample_rate) noexcept
+{
+    double const fs = static_cast<double>(sample_rate);
+    std::array<Biquad, 2> filters;
+
+    double f0 = 1681.974450955533;
+    double q = 0.7071752369554196;
+    double k = std::tan(_pi * f0 / fs);
+    double const vh = std::pow(10., 3.999843853973347 / 20.);
+    double const vb = std::pow(vh, 0.4996667741545416);
+    double a0 = 1. + k / q + k * k;
+    filters[0] = {
+        (vh + vb * k / q + k * k) / a0,
+        2. * (k * k - vh) / a0,
+        (vh - vb * k / q + k * k) / a0,
+        2. * (k * k - 1.) / a0,
+        (1. - k / q + k * k) / a0,
+    };
+
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = std::tan(_pi * f0 / fs);
+    a0 = 1. + k / q + k * k;
+    filters[1] = { 1., -2., 1., 2. * (k * k - 1.) / a0, (1. - k / q + k * k) / a0 };
+    return filters;
+}
+
+
+static void _initState(AnalysisState& state, AnalyzerSettings const& settings,
+    int channels, int sample_rate)
+{
+    size_t const block = static_cast<size_t>(std::max(settings.block_frames, 1));
+    state.channels = channels;
+    state.sample_rate = sample_rate;
+    state.input.resize(block * channels);
+    state.samples.resize(block * channels);
+
+    size_t const n = std::bit_ceil(static_cast<size_t>(std::max(settings.fft_size, 2)));
+    state.fft_size = n;
+    state.history.assign(n, 0.f);
+    state.window.resize(n);
+    double window_sum = 0.;
+    for (size_t i = 0; i < n; ++i) {
+        state.window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2. * _pi * i / n));
+        window_sum += state.window[i];
+    }
+    // Full scale sine peaks at 0 dBFS
+    state.spectrum_scale = static_cast<float>(2. / window_sum);
+    state.bit_reverse.resize(n);
+    uint32_t const bits = static_cast<uint32_t>(std::countr_zero(n));
+    for (uint32_t i = 0; i < n; ++i) {
+        uint32_t reversed = 0;
+        for (uint32_t b = 0; b < bits; ++b) {
+            reversed |= ((i >> b) & 1U) << (bits - 1 - b);
+        }
+        state.bit_reverse[i] = reversed;
+    }
+    state.twiddle_re.resize(n);
+    state.twiddle_im.resize(n);
+    for (size_t half = 1; half < n; half *= 2) {
+        for (size_t k = 0; k < half; ++k) {
+            double const angle = -_pi * static_cast<double>(k) / static_cast<double>(half);
+            state.twiddle_re[half - 1 + k] = static_cast<float>(std::cos(angle));
+            state.twiddle_im[half - 1 + k] = static_cast<float>(std::sin(angle));
+        }
+    }
+    state.re.resize(n);
+    state.im.resize(n);
+
+    state.k_weighting = _getKWeighting(sample_rate);
+    state.k_states.assign(channels, {});
+    state.sub_length = static_cast<size_t>(std::max(sample_rate / 10, 1));
+    state.sub_frames = 0;
+    state.sub_sum = 0.;
+    state.sub_count = 0;
+    state.gated_counts.fill(0);
+    state.gated_powers.fill(0.);
+    state.integrated_lufs = -std::numeric_limits<float>::infinity();
+}
+
+
+static void _resetLoudness(AnalysisState& state) noexcept
+{
+    state.gated_counts.fill(0);
+    state.gated_powers.fill(0.);
+    state.integrated_lufs = -std::numeric_limits<float>::infinity();
+}
+
+
+// Relative gate at -10 LU of the absolute-gated loudness
+static float _integrate(AnalysisState const& state) noexcept
+{
+    uint64_t count = 0;
+    double power = 0.;
+    for (size_t i = 0; i < _histogram_bins; ++i) {
+        count += state.gated_counts[i];
+        power += state.gated_powers[i];
+    }
+    if (count == 0)
+        return -std::numeric_limits<float>::infinity();
+    double const relative_gate = _toLUFS(power / static_cast<double>(count)) - 10.;
+    double const first = std::max(std::ceil((relative_gate - _gate_lufs) * 10.), 0.);
+    count = 0;
+    power = 0.;
+    for (size_t i = static_cast<size_t>(first); i < _histogram_bins; ++i) {
+        count += state.gated_counts[i];
+        power += state.gated_powers[i];
+    }
+    return count == 0 ? -std::numeric_limits<float>::infinity()
+        : _toLUFS(power / static_cast<double>(count));
+}
+
+
+// K-weights the block into 100ms sub-blocks, closing 400ms gating blocks
+static void _measureLoudness(AnalysisState& state, size_t frames)
+{
+    size_t const channels = static_cast<size_t>(state.channels);
+    Biquad const& pre = state.k_weighting[0];
+    Biquad const& rlb = state.k_weighting[1];
+    for (size_t f = 0; f < frames; ++f) {
+        for (size_t c = 0; c < channels; ++c) {
+            std::array<double, 8>& z = state.k_states[c];
+            double const x = state.samples[f * channels + c];
+            double const y = pre.b0 * x + pre.b1 * z[0] + pre.b2 * z[1] - pre.a1 * z[2] - pre.a2 * z[3];
+            z[1] = z[0]; z[0] = x; z[3] = z[2]; z[2] = y;
+            double const w = rlb.b0 * y + rlb.b1 * z[4] + rlb.b2 * z[5] - rlb.a1 * z[6] - rlb.a2 * z[7];
+            z[5] = z[4]; z[4] = y; z[7] = z[6]; z[6] = w;
+            state.sub_sum += w * w;
+        }
+        if (++state.sub_frames < state.sub_length)
+            continue;
+        state.subs[state.sub_count % state.subs.size()] = state.sub_sum / static_cast<double>(state.sub_length);
+        ++state.sub_count;
+        state.sub_frames = 0;
+        state.sub_sum = 0.;
+        if (state.sub_count < 4)
+            continue;
+        double power = 0.;
+        for (uint64_t i = state.sub_count - 4; i < state.sub_count; ++i) {
+            power += state.subs[i % state.subs.size()];
+        }
+        power /= 4.;
+        double const lufs = _toLUFS(power);
+        if (lufs > _gate_lufs) {
+            size_t const bin = std::min(static_cast<size_t>((lufs - _gate_lufs) * 10.), _histogram_bins - 1);
+            ++state.gated_counts[bin];
+            state.gated_powers[bin] += power;
+            state.integrated_lufs = _integrate(state);
+        }
+    }
+}
+
+
+static float _windowLoudness(AnalysisState const& state, uint64_t subs) noexcept
+{
+    if (state.sub_count < subs)
+        return -std::numeric_limits<float>::infinity();
+    double power = 0.;
+    for (uint64_t i = state.sub_count - subs; i < state.sub_count; ++i) {
+        power += state.subs[i % state.subs.size()];
+    }
+    return _toLUFS(power / static_cast<double>(subs));
+}
+
+
+// In-place radix-2 FFT of re & im, input already in bit-reversed order
+static void _fft(AnalysisState& state) noexcept
+{
+    size_t const n = state.fft_size;
+    float* const re = state.re.data();
+    float* const im = state.im.data();
+    for (size_t half = 1; half < n; half *= 2) {
+        float const* __restrict w_re = &state.twiddle_re[half - 1];
+        float const* __restrict w_im = &state.twiddle_im[half - 1];
+        for (size_t start = 0; start < n; start += 2 * half) {
+            float* __restrict a_re = re + start;
+            float* __restrict a_im = im + start;
+            float* __restrict b_re = a_re + half;
+            float* __restrict b_im = a_im + half;
+            for (size_t k = 0; k < half; ++k) {
+                float const t_re = b_re[k] * w_re[k] - b_im[k] * w_im[k];
+                float const t_im = b_re[k] * w_im[k] + b_im[k] * w_re[k];
+                b_re[k] = a_re[k] - t_re;
+                b_im[k] = a_im[k] - t_im;
+                a_re[k] += t_re;
+                a_im[k] += t_im;
+            }
+        }
+    }
+}
+
+
+static void _computeSpectrum(AnalysisState& state, size_t frames, std::vector<float>& spectrum)
+{
+    size_t const n = state.fft_size;
+    size_t const channels = static_cast<size_t>(state.channels);
+    float const gain = 1.f / static_cast<float>(channels);
+
+    // Slide the mono history by the new block
+    size_t const kept = n > frames ? n - frames : 0;
+    std::copy(state.history.end() - kept, state.history.end(), state.history.begin());
+    size_t const skipped = frames - (n - kept);
+    for (size_t f = 0; f + kept < n; ++f) {
+        float sum = 0.f;
+        for (size_t c = 0; c < channels; ++c) {
+            sum += state.samples[(skipped + f) * channels + c];
+        }
+        state.history[kept + f] = sum * gain;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        state.re[state.bit_reverse[i]] = state.history[i] * state.window[i];
+    }
+    std::fill(state.im.begin(), state.im.end(), 0.f);
+    _fft(state);
+
+    size_t const bins = n / 2 + 1;
+    spectrum.resize(bins);
+    float const scale = state.spectrum_scale * state.spectrum_scale;
+    float const* __restrict re = state.re.data();
+    float const* __restrict im = state.im.data();
+    float* __restrict out = spectrum.data();
+    for (size_t i = 0; i < bins; ++i) {
+        out[i] = std::max((re[i] * re[i] + im[i] * im[i]) * scale, 1e-20f);
+    }
+    for (size_t i = 0; i < bins; ++i) {
+        out[i] = 10.f * std::log10(out[i]);
+    }
+}
+
+INTERNAL_END;
+
+
+std::map<uint32_t, std::unique_ptr<Analyzer>> Analyzer::_instances{};
+
+
+static size_t _getCapacity(AnalyzerSettings const& settings)
+{
+    int const frames = settings.buffer_frames > 0
+        ? settings.buffer_frames : std::max(settings.block_frames, 1) * 16;
+    // Room for stereo input
+    return static_cast<size_t>(frames) * 2;
+}
+
+
+Analyzer::Analyzer(uint32_t id, AnalyzerSettings const& settings)
+    : _map_id(id), _settings(settings), _ring(_getCapacity(settings)),
+    _state(std::make_unique<_internal::AnalysisState>())
+{
+    _running = true;
+    _thread = std::thread(&Analyzer::_run, this);
+}
+
+
+Analyzer::~Analyzer()
+{
+    _running = false;
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+
+Analyzer& Analyzer::create(uint32_t id, AnalyzerSettings const& settings) try
+{
+    std::lock_guard const lock(_internal::getMutex());
+    _instances[id].reset(new Analyzer(id, settings));
+    return *_instances.at(id);
+}
+CATCH_AND_RETHROW_FUNC_EXC;
+
+
+Analyzer& Analyzer::create(AnalyzerSettings const& settings) try
+{
+    std::lock_guard const lock(_internal::getMutex());
+    uint32_t id = 0;
+    // Increment ID until no similar value is found
+    while (_instances.count(id) != 0) {
+        ++id;
+    }
+    return create(id, settings);
+}
+CATCH_AND_RETHROW_FUNC_EXC;
+
+
+Analyzer* Analyzer::get(uint32_t id) noexcept
+{
+    auto const it = _instances.find(id);
+    if (it == _instances.cend())
+        return nullptr;
+    return it->second.get();
+}
+
+
+void Analyzer::remove(uint32_t id)
+{
+    std::lock_guard const lock(_internal::getMutex());
+    _instances.erase(id);
+}
+
+
+void Analyzer::clearAll() noexcept
+{
+    std::lock_guard const lock(_internal::getMutex());
+    _instances.clear();
+}
+
+
+void Analyzer::feed(short const* samples, size_t frames, int channels, int sample_rate) noexcept
+{
+    if (_channels == 0 && (channels == 1 || channels == 2) && sample_rate > 0) {
+        _sample_rate = sample_rate;
+        _channels = channels;
+    }
+    if (channels != _channels || sample_rate != _sample_rate) {
+        _dropped += frames;
+        return;
+    }
+    size_t remaining = frames * static_cast<size_t>(channels);
+    for (std::span<short> const span : _ring.writable()) {
+        size_t const count = std::min(span.size(), remaining);
+        std::copy_n(samples, count, span.data());
+        _ring.commit(count);
+        samples += count;
+        remaining -= count;
+    }
+    _dropped += remaining / static_cast<size_t>(channels);
+}
+
+
+AnalysisResult const& Analyzer::getResult() noexcept
+{
+    _results.update();
+    return _results.front();
+}
+
+
+MeterLevels Analyzer::getLevels() const noexcept
+{
+    return MeterLevels{
+        _peak.load(std::memory_order_relaxed),
+        _rms.load(std::memory_order_relaxed),
+        _momentary_lufs.load(std::memory_order_relaxed)
+    };
+}
+
+
+void Analyzer::_run()
+{
+    size_t const block = static_cast<size_t>(std::max(_settings.block_frames, 1));
+    while (_running) {
+        int const channels = _channels;
+        if (channels == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            continue;
+        }
+        if (_state->channels == 0) {
+            _internal::_initState(*_state, _settings, channels, _sample_rate);
+        }
+        size_t const count = block * static_cast<size_t>(channels);
+        if (_ring.size() < count) {
+            // Half a block, so results keep up with real-time input
+            std::this_thread::sleep_for(std::chrono::microseconds(
+                std::max<int64_t>(500000LL * static_cast<int64_t>(block) / _state->sample_rate, 250)));
+            continue;
+        }
+        size_t copied = 0;
+        for (std::span<short const> const span : _ring.readable()) {
+            size_t const n = std::min(span.size(), count - copied);
+            std::copy_n(span.data(), n, _state->input.data() + copied);
+            copied += n;
+        }
+        _ring.release(count);
+        _analyze();
+    }
+}
+
+
+void Analyzer::_analyze()
+{
+    _internal::AnalysisState& state = *_state;
+    size_t const count = state.input.size();
+    size_t const frames = count / static_cast<size_t>(state.channels);
+    if (_reset_loudness.exchange(false)) {
+        _internal::_resetLoudness(state);
+    }
+
+    // Plain loops over floats, vectorized by the compiler. Reductions use
+    // independent lanes, as float sums can't be reordered otherwise.
+    short const* __restrict input = state.input.data();
+    float* __restrict samples = state.samples.data();
+    for (size_t i = 0; i < count; ++i) {
+        samples[i] = static_cast<float>(input[i]) * (1.f / 32768.f);
+    }
+    constexpr size_t lanes = 8;
+    std::array<float, lanes> peaks{};
+    std::array<float, lanes> sums{};
+    size_t i = 0;
+    for (; i + lanes <= count; i += lanes) {
+        for (size_t j = 0; j < lanes; ++j) {
+            float const sample = samples[i + j];
+            peaks[j] = std::max(peaks[j], sample < 0.f ? -sample : sample);
+            sums[j] += sample * sample;
+        }
+    }
+    for (; i < count; ++i) {
+        peaks[0] = std::max(peaks[0], std::abs(samples[i]));
+        sums[0] += samples[i] * samples[i];
+    }
+    float peak = 0.f;
+    float sum = 0.f;
+    for (size_t j = 0; j < lanes; ++j) {
+        peak = std::max(peak, peaks[j]);
+        sum += sums[j];
+    }
+
+    _internal::_measureLoudness(state, frames);
+
+    AnalysisResult& result = _results.back();
+    _internal::_computeSpectrum(state, frames, result.spectrum);
+    result.blocks = ++state.blocks;
+    result.sample_rate = state.sample_rate;
+    result.peak = peak;
+    result.rms = std::sqrt(sum / static_cast<float>(count));
+    result.momentary_lufs = _internal::_windowLoudness(state, 4);
+    result.short_term_lufs = _internal::_windowLoudness(state, 30);
+    result.integrated_lufs = state.integrated_lufs;
+    _peak.store(result.peak, std::memory_order_relaxed);
+    _rms.store(result.rms, std::memory_order_relaxed);
+    _momentary_lufs.store(result.momentary_lufs, std::memory_order_relaxed);
+    _results.publish();
+}
+
+SSS_AUDIO_END
\ No newline at end of file
@@ -0,0 +1,168 @@
+#include "Audio/Automation.hpp"
+#include "Audio/Source.hpp"
+#include "Audio/Trace.hpp"
+
+#include <cmath>
+#include <numbers>
+
+SSS_AUDIO_BEGIN;
+INTERNAL_BEGIN;
+
+using Clock = std::chrono::steady_clock;
+
+struct Lane {
+    uint32_t source_id;
+    Automated param;
+    Clock::time_point segment_start;
+    std::array<float, 3> start;
+    size_t segment{ 0 };
+    std::vector<Segment> segments;
+};
+
+// Guarded by getMutex()
+static std::vector<Lane> _lanes;
+// Evaluated values, one entry per lane, reused across ticks
+static std::vector<std::array<float, 3>> _values;
+
+
+// Maps t in [0, 1] to the interpolated value between a & b
+static float _interpolate(float a, float b, float t, Curve curve) noexcept
+{
+    switch (curve) {
+    case Curve::Exponential: {
+        // Interpolate in log space, 0 can't be reached geometrically
+        float constexpr floor = 1e-4f;
+        float const from = std::max(a, floor), to = std::max(b, floor);
+        float const value = from * std::pow(to / from, t);
+        return (t >= 1.f) ? b : value;
+    }
+    case Curve::SCurve:
+        t = t * t * (3.f - 2.f * t);
+        break;
+    case Curve::EqualPower:
+        t = (b >= a)
+            ? std::sin(t * std::numbers::pi_v<float> * 0.5f)
+            : 1.f - std::cos(t * std::numbers::pi_v<float> * 0.5f);
+        break;
+    default:
+        break;
+    }
+    return a + (b - a) * t;
+}
+
+
+void automate(uint32_t source_id, Automated param, std::array<float, 3> const& start,
+    std::vector<Segment> segments)
+{
+    std::lock_guard const lock(getMutex());
+    stopAutomation(source_id, param);
+    if (segments.empty())
+        return;
+    _lanes.push_back(Lane{ source_id, param, Clock::now(), start, 0, std::move(segments) });
+}
+
+
+void stopAutomation(uint32_t source_id, Automated param)
+{
+    std::lock_guard const lock(getMutex());
+    std::erase_if(_lanes, [&](Lane const& lane) {
+        return lane.source_id == source_id && lane.param == param;
+    });
+}
+
+
+void stopAutomation(uint32_t source_id)
+{
+    std::lock_guard const lock(getMutex());
+    std::erase_if(_lanes, [&](Lane const& lane) { return lane.source_id == source_id; });
+}
+
+
+void updateAutomation()
+{
+    std::lock_guard const lock(getMutex());
+    if (_lanes.empty())
+        return;
+
+    Clock::time_point const now = Clock::now();
+    size_t const count = _lanes.size();
+    _values.resize(count);
+
+    // Evaluate every lane first, without touching OpenAL
+    for (size_t i = 0; i < count; ++i) {
+        Lane& lane = _lanes[i];
+        // Skip completed segments
+        float elapsed = std::chrono::duration<float>(now - lane.segment_start).count();
+        while (lane.segment < lane.segments.size()
+            && elapsed >= lane.segments[lane.segment].duration)
+        {
+            Segment const& done = lane.segments[lane.segment];
+            lane.start = done.target;
+            lane.segment_start += std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<float>(done.duration));
+            elapsed -= done.duration;
+            ++lane.segment;
+        }
+        if (lane.segment >= lane.segments.size()) {
+            _values[i] = lane.start;
+            continue;
+        }
+        Segment const& segment = lane.segments[lane.segment];
+        float const t = elapsed / segment.duration;
+        // Position isn't a magnitude, exponential ramps make no sense there
+        Curve const curve = (lane.param == Automated::Position && segment.curve == Curve::Exponential)
+            ? Curve::Linear : segment.curve;
+        for (size_t j = 0; j < 3; ++j) {
+            _values[i][j] = _interpolate(lane.start[j], segment.target[j], t, curve);
+        }
+    }
+
+    // Apply values, then drop finished lanes
+    for (size_t i = 0; i < count; ++i) {
+        Lane const& lane = _lanes[i];
+        Source* source = Source::get(lane.source_id);
+        if (!source)
+            continue;
+        std::array<float, 3> const& value = _values[i];
+        source->_bind();
+        switch (lane.param) {
+        case Automated::Gain:
+            source->_gain = value[0];
+            source->_applyGain();
+            break;
+        case Automated::Pitch:
+            alSourcef(source->_openal_id, AL_PITCH, value[0]);
+            break;
+        case Automated::Position:
+            alSource3f(source->_openal_id, AL_POSITION, value[0], value[1], value[2]);
+            break;
+        }
+    }
+    std::erase_if(_lanes, [](Lane const& lane) {
+        return lane.segment >= lane.segments.size() || !Source::get(lane.source_id);
+    });
+}
+
+INTERNAL_END;
+
+
+void crossfade(uint32_t from_id, uint32_t to_id, float seconds, Curve curve) try
+{
+    _internal::TraceCall const trace(TraceOp::Crossfade, from_id, to_id, seconds, static_cast<int32_t>(curve));
+    Source* from = Source::get(from_id);
+    Source* to = Source::get(to_id);
+    if (!from || !to) {
+        LOG_CTX_WRN("SSS/Audio", "Found no Source to crossfade at given ID.");
+        return;
+    }
+    float const target = std::max(from->getGain(), to->getGain());
+    if (!to->isPlaying()) {
+        to->setGain(0.f);
+        to->play();
+    }
+    from->fadeGain(0.f, seconds, curve);
+    to->fadeGain(target, seconds, curve);
+}
+CATCH_AND_LOG_FUNC_EXC;
+
+SSS_AUDIO_END;
\ No newline at end of file
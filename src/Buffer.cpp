@@ -1,5 +1,7 @@
 #include "Audio/Buffer.hpp"
 #include "Audio/Source.hpp"
+#include "Audio/Decoder.hpp"
+#include "Audio/Trace.hpp"
 
 SSS_AUDIO_BEGIN;
 
@@ -27,20 +29,16 @@ INTERNAL_END;
 
 
 std::map<uint32_t, std::unique_ptr<Buffer>> Buffer::_instances{};
+Compression Buffer::_default_compression{};
 
 
 Buffer::Buffer(uint32_t id)
-    : _openal_id([]() {
-        init();
-        ALuint buffer;
-        alGenBuffers(1, &buffer);
-        if (buffer == 0) {
-            SSS::throw_exc("Couldn't generate an OpenAL buffer: " + _internal::getALErrorString(alGetError()));
-        }
-        return buffer;
-    }()),
-    _map_id(id)
+    : _map_id(id)
 {
+    // Without a device, the OpenAL buffer is generated on upload
+    if (_internal::is_init()) {
+        _generate();
+    }
 }
 
 
@@ -56,6 +54,8 @@ Buffer::~Buffer()
 
 Buffer& Buffer::create(uint32_t id)
 {
+    _internal::TraceCall const trace(TraceOp::BufferCreate, id);
+    std::lock_guard const lock(_internal::getMutex());
     _instances[id].reset(new Buffer(id));
     return *_instances.at(id);
 }
@@ -63,6 +63,7 @@ Buffer& Buffer::create(uint32_t id)
 
 Buffer& Buffer::create()
 {
+    std::lock_guard const lock(_internal::getMutex());
     uint32_t id = 0;
     // Increment ID until no similar value is found
     while (_instances.count(id) != 0) {
@@ -89,67 +90,278 @@ Buffer* Buffer::get(uint32_t id) noexcept
 
 void Buffer::remove(uint32_t id)
 {
+    _internal::TraceCall const trace(TraceOp::BufferRemove, id);
+    std::lock_guard const lock(_internal::getMutex());
     if (_instances.count(id) == 0) {
         _instances.erase(_instances.find(id));
     }
 }
 
 
+void Buffer::clearAll() noexcept
+{
+    std::lock_guard const lock(_internal::getMutex());
+    _instances.clear();
+}
+
+
 void Buffer::loadFile(const std::string& filename) try
 {
-    // Open audio file
-    SF_INFO file_infos;
-    SNDFILE* file = sf_open(filename.c_str(), SFM_READ, &file_infos);
-    if (file == nullptr) {
-        SSS::throw_exc("Couldn't open " + filename);
-    }
-    // Extract sample size & rate
-    ALsizei const sample_nb = static_cast<ALsizei>(file_infos.channels * file_infos.frames);
-    ALsizei const sample_hz = static_cast<ALsizei>(file_infos.samplerate);
-    // Read by chunks of 16 bits
-    std::vector<short> samples(sample_nb);
-    sf_count_t const read_nb = sf_readf_short(file, &samples[0], sample_nb);
-    if (read_nb < sample_nb) {
-        //SSS::throw_exc("Error reading " + filename);
-    }
-    // Close audio file
-    sf_close(file);
-
-    // Determine format
-    ALenum format;
-    switch (file_infos.channels) {
-    case 1:
-        format = AL_FORMAT_MONO16;
-        break;
-    case 2:
-        format = AL_FORMAT_STEREO16;
-        break;
-    default:
-        SSS::throw_exc("Unsupported file format");
+    _internal::TraceCall const trace(TraceOp::BufferLoadFile, _map_id, filename);
+    // Open audio file with the fastest available backend
+    std::unique_ptr<_internal::DecoderHandle> decoder = _internal::openDecoder(filename);
+    AudioInfo const info = decoder->getInfo();
+    std::optional<LoopPoints> const loop_points = decoder->getLoopPoints();
+    ALenum const format = _internal::getFormat(info.channels);
+    ALsizei const sample_hz = static_cast<ALsizei>(info.sample_rate);
+    // Read by chunks of 16 bits, frame count may be unknown or inexact
+    size_t constexpr chunk = 1 << 16;
+    std::vector<short> samples(static_cast<size_t>(std::max<int64_t>(info.frames, 0)) * info.channels);
+    size_t frames = 0;
+    while (true) {
+        if (samples.size() < (frames + chunk) * info.channels) {
+            samples.resize((frames + chunk) * info.channels);
+        }
+        size_t const read = decoder->read(&samples[frames * info.channels], chunk);
+        if (read == 0)
+            break;
+        frames += read;
+    }
+    decoder.reset();
+    samples.resize(frames * info.channels);
+
+    std::unique_ptr<Pending> pending(new Pending{ format, sample_hz, info.channels, std::move(samples), std::nullopt });
+    // Encoding needs the device to know which formats are supported
+    if (_internal::is_init()) {
+        _compress(*pending);
+    }
+
+    std::lock_guard const lock(_internal::getMutex());
+    _pending = std::move(pending);
+    _uploaded.reset();
+    _filename = filename;
+    _loop_points = loop_points;
+    // Upload is deferred until the device exists
+    if (_internal::is_init()) {
+        _upload();
+    }
+}
+CATCH_AND_LOG_METHOD_EXC;
+
+
+void Buffer::setCompression(Compression const& compression) noexcept
+{
+    _compression = compression;
+}
+
+
+void Buffer::setDefaultCompression(Compression const& compression) noexcept
+{
+    _default_compression = compression;
+}
+
+
+void Buffer::setLoopPoints(std::optional<LoopPoints> loop)
+{
+    std::lock_guard const lock(_internal::getMutex());
+    _loop_points = loop;
+    if (_openal_id != 0 && !_pending) {
+        _applyLoopPoints();
+    }
+}
+
+
+BufferMemory Buffer::getTotalMemory() noexcept
+{
+    std::lock_guard const lock(_internal::getMutex());
+    BufferMemory total;
+    for (auto const& pair : _instances) {
+        total.pcm_bytes += pair.second->_memory.pcm_bytes;
+        total.stored_bytes += pair.second->_memory.stored_bytes;
+    }
+    return total;
+}
+
+
+ALint Buffer::getProperty(ALenum param) const
+{
+    ALint ret = 0;
+    if (_openal_id == 0)
+        return ret;
+    alGetBufferi(_openal_id, param, &ret);
+    return ret;;
+}
+
+
+
+void Buffer::_suspendAll()
+{
+    for (auto const& pair : _instances) {
+        Buffer& buffer = *pair.second;
+        if (buffer._openal_id != 0) {
+            alDeleteBuffers(1, &buffer._openal_id);
+            buffer._openal_id = 0;
+        }
+    }
+}
+
+
+void Buffer::_resumeAll()
+{
+    for (auto const& pair : _instances) {
+        Buffer& buffer = *pair.second;
+        try {
+            // Loaded during the migration
+            if (buffer._pending) {
+                buffer._upload();
+                continue;
+            }
+            // Filled from memory, nothing to reload it from
+            if (buffer._uploaded) {
+                buffer._pending = std::move(buffer._uploaded);
+                buffer._upload();
+            }
+            else if (!buffer._filename.empty()) {
+                // Keep loop points set after loading
+                std::optional<LoopPoints> const loop_points = buffer._loop_points;
+                buffer.loadFile(buffer._filename);
+                buffer.setLoopPoints(loop_points);
+            }
+            else {
+                buffer._generate();
+            }
+        }
+        CATCH_AND_LOG_FUNC_EXC;
+    }
+}
+
+
+void Buffer::_uploadAll()
+{
+    std::lock_guard const lock(_internal::getMutex());
+    for (auto const& pair : _instances) {
+        Buffer& buffer = *pair.second;
+        try {
+            if (buffer._pending) {
+                buffer._upload();
+            }
+            else if (buffer._openal_id == 0) {
+                buffer._generate();
+            }
+        }
+        CATCH_AND_LOG_FUNC_EXC;
+    }
+}
+
+
+void Buffer::_generate()
+{
+    alGenBuffers(1, &_openal_id);
+    if (_openal_id == 0) {
+        SSS::throw_exc("Couldn't generate an OpenAL buffer: " + _internal::getALErrorString(alGetError()));
+    }
+}
+
+
+void Buffer::_compress(Pending& pending) const
+{
+    using Format = Compression::Format;
+    Format const format = _compression.format;
+    if (format == Format::PCM16 || pending.encoded || pending.samples.empty())
+        return;
+    if (!_internal::isSupported(format)) {
+        LOG_METHOD_CTX_WRN("Compression unsupported by device, keeping PCM", static_cast<int>(format));
+        return;
+    }
+    // Custom block sizes need AL_SOFT_block_alignment
+    int block_frames = _compression.block_frames;
+    if (alIsExtensionPresent("AL_SOFT_block_alignment") != AL_TRUE) {
+        block_frames = 0;
     }
+    size_t const frames = pending.samples.size() / pending.channels;
+    pending.encoded = format == Format::IMA4
+        ? _internal::encodeIMA4(pending.samples.data(), frames, pending.channels, block_frames)
+        : _internal::encodeMSADPCM(pending.samples.data(), frames, pending.channels, block_frames);
+}
 
+
+void Buffer::_upload()
+{
+    if (_openal_id == 0) {
+        _generate();
+    }
+    // Loaded before the device existed
+    _compress(*_pending);
     // Ensure buffer isn't attached to any source
     _removeFromSources();
 
     // Fill buffer
-    alBufferData(_openal_id, format, &samples[0], sample_nb * sizeof(short), sample_hz);
+    Pending const& pending = *_pending;
+    // Samples of encoded data are dropped once uploaded, see below
+    if (!pending.encoded || !pending.samples.empty()) {
+        _memory.pcm_bytes = pending.samples.size() * sizeof(short);
+        _frames = pending.samples.size() / pending.channels;
+    }
+    // Alignment persists on the buffer, 0 resetting it to the format default
+    if (alIsExtensionPresent("AL_SOFT_block_alignment") == AL_TRUE) {
+        alBufferi(_openal_id, AL_UNPACK_BLOCK_ALIGNMENT_SOFT,
+            pending.encoded ? pending.encoded->block_frames : 0);
+    }
+    if (pending.encoded) {
+        _internal::Encoded const& encoded = *pending.encoded;
+        alBufferData(_openal_id, encoded.format, encoded.data.data(),
+            static_cast<ALsizei>(encoded.data.size()), pending.sample_hz);
+        _memory.stored_bytes = encoded.data.size();
+    }
+    else {
+        alBufferData(_openal_id, pending.format, pending.samples.data(),
+            static_cast<ALsizei>(pending.samples.size() * sizeof(short)), pending.sample_hz);
+        _memory.stored_bytes = _memory.pcm_bytes;
+    }
     ALenum err = alGetError();
     if (err != AL_NO_ERROR) {
+        _pending.reset();
+        _uploaded.reset();
         SSS::throw_exc("Error filling buffer: " + _internal::getALErrorString(err));
     }
+    // Files are reloaded on device migration, other data must be kept.
+    // Only what OpenAL received is.
+    if (!_filename.empty()) {
+        _pending.reset();
+    }
+    else {
+        if (pending.encoded) {
+            _pending->samples.clear();
+            _pending->samples.shrink_to_fit();
+        }
+        _uploaded = std::move(_pending);
+    }
+    _applyLoopPoints();
 }
-CATCH_AND_LOG_METHOD_EXC;
 
 
-ALint Buffer::getProperty(ALenum param) const
+void Buffer::_applyLoopPoints()
 {
-    ALint ret;
-    alGetBufferi(_openal_id, param, &ret);
-    return ret;;
+    if (alIsExtensionPresent("AL_SOFT_loop_points") != AL_TRUE) {
+        if (_loop_points) {
+            LOG_METHOD_CTX_WRN("AL_SOFT_loop_points unsupported, looping whole buffer", _map_id);
+        }
+        return;
+    }
+    // Whole buffer when no loop is set
+    std::array<ALint, 2> points{ 0, static_cast<ALint>(_frames) };
+    if (_loop_points) {
+        points = { static_cast<ALint>(_loop_points->start), static_cast<ALint>(_loop_points->end) };
+    }
+    else if (_frames == 0)
+        return;
+    alBufferiv(_openal_id, AL_LOOP_POINTS_SOFT, points.data());
+    if (ALenum const err = alGetError(); err != AL_NO_ERROR) {
+        LOG_METHOD_CTX_WRN("Couldn't set loop points", _internal::getALErrorString(err));
+    }
 }
 
 
-
 void Buffer::_removeFromSources() noexcept try
 {
     for (auto const& source : Source::getArray()) {
@@ -0,0 +1,384 @@
+#include "Audio/Bus.hpp"
+#include "Audio/Source.hpp"
+#include "Audio/Trace.hpp"
+
+#include <cmath>
+
+SSS_AUDIO_BEGIN;
+
+
+std::map<std::string, std::unique_ptr<Bus>> Bus::_instances{};
+bool Bus::_hierarchy_changed{ true };
+bool Bus::_gains_changed{ true };
+std::vector<Bus*> Bus::_source_buses{};
+
+
+Bus::Bus(std::string const& name)
+    : _name(name)
+{
+}
+
+
+Bus::~Bus()
+{
+    // Move Sources & children back to the root
+    for (auto const& source : Source::getArray()) {
+        if (source && source->_bus == _name) {
+            source->_bus.clear();
+            source->_bus_gain = 1.f;
+            source->_applyGain();
+        }
+    }
+    for (auto const& pair : _instances) {
+        if (pair.second && pair.second->_parent == _name) {
+            pair.second->_parent.clear();
+        }
+    }
+    _hierarchy_changed = true;
+    // Nothing would resume Sources this bus paused otherwise
+    _resumeSources(_paused_sources);
+}
+
+
+Bus& Bus::create(std::string const& name, std::string const& parent) try
+{
+    if (name.empty()) {
+        SSS::throw_exc("Bus name can't be empty.");
+    }
+    _internal::TraceCall const trace(TraceOp::BusCreate, name, parent);
+    std::lock_guard const lock(_internal::getMutex());
+    auto& ptr = _instances[name];
+    if (!ptr) {
+        ptr.reset(new Bus(name));
+        _hierarchy_changed = true;
+    }
+    ptr->setParent(parent);
+    return *ptr;
+}
+CATCH_AND_RETHROW_FUNC_EXC;
+
+
+Bus* Bus::get(std::string const& name) noexcept
+{
+    auto const it = _instances.find(name);
+    if (it == _instances.cend())
+        return nullptr;
+    return it->second.get();
+}
+
+
+void Bus::remove(std::string const& name)
+{
+    _internal::TraceCall const trace(TraceOp::BusRemove, name);
+    std::lock_guard const lock(_internal::getMutex());
+    auto const it = _instances.find(name);
+    if (it != _instances.end()) {
+        // Destroy before erasing, as the destructor walks the map
+        it->second.reset();
+        _instances.erase(it);
+        _internal::updateBuses();
+    }
+}
+
+
+void Bus::clearAll() noexcept
+{
+    std::lock_guard const lock(_internal::getMutex());
+    for (auto& pair : _instances) {
+        pair.second.reset();
+    }
+    _instances.clear();
+}
+
+
+void Bus::setParent(std::string const& name)
+{
+    _internal::TraceCall const trace(TraceOp::BusSetParent, _name, name);
+    std::lock_guard const lock(_internal::getMutex());
+    if (!name.empty()) {
+        Bus const* parent = get(name);
+        if (!parent) {
+            LOG_METHOD_CTX_WRN("Couldn't find a bus with given name", name);
+            return;
+        }
+        if (parent->isWithin(_name)) {
+            LOG_METHOD_CTX_WRN("Bus hierarchy can't be cyclic", name);
+            return;
+        }
+    }
+    _parent = name;
+    _hierarchy_changed = true;
+    _internal::updateBuses();
+}
+
+
+void Bus::setGain(float gain)
+{
+    _internal::TraceCall const trace(TraceOp::BusSetGain, _name, gain);
+    std::lock_guard const lock(_internal::getMutex());
+    _gain = gain;
+    _gains_changed = true;
+    _internal::updateBuses();
+}
+
+
+void Bus::setMuted(bool muted)
+{
+    _internal::TraceCall const trace(TraceOp::BusSetMuted, _name, muted);
+    std::lock_guard const lock(_internal::getMutex());
+    _muted = muted;
+    _gains_changed = true;
+    _internal::updateBuses();
+}
+
+
+void Bus::setPaused(bool paused)
+{
+    _internal::TraceCall const trace(TraceOp::BusSetPaused, _name, paused);
+    std::lock_guard const lock(_internal::getMutex());
+    if (paused == _paused)
+        return;
+    _paused = paused;
+
+    // Batched per context, as OpenAL sources only exist within theirs
+    std::array<std::vector<ALuint>, _internal::max_contexts> openal_ids;
+    if (paused) {
+        for (Source* source : _getSources()) {
+            if (source->isPlaying()) {
+                openal_ids[source->_context_id].push_back(source->_openal_id);
+                _paused_sources.push_back(source->_arr_id);
+            }
+        }
+        for (uint32_t i = 0; i < openal_ids.size(); ++i) {
+            if (!openal_ids[i].empty()) {
+                _internal::bindContext(i);
+                alSourcePausev(static_cast<ALsizei>(openal_ids[i].size()), openal_ids[i].data());
+            }
+        }
+    }
+    else {
+        std::vector<uint32_t> const ids = std::move(_paused_sources);
+        _paused_sources.clear();
+        _resumeSources(ids);
+    }
+}
+
+
+bool Bus::isPaused() const noexcept
+{
+    for (Bus const* bus = this; bus != nullptr; bus = get(bus->_parent)) {
+        if (bus->_paused)
+            return true;
+    }
+    return false;
+}
+
+
+void Bus::duckUnder(std::string const& trigger, float gain, float attack, float release)
+{
+    _internal::TraceCall const trace(TraceOp::BusDuckUnder, _name, trigger, gain, attack, release);
+    std::lock_guard const lock(_internal::getMutex());
+    if (trigger == _name) {
+        LOG_METHOD_CTX_WRN("A bus can't duck under itself", trigger);
+        return;
+    }
+    for (Ducking& ducking : _duckings) {
+        if (ducking.trigger == trigger) {
+            ducking.gain = gain;
+            ducking.attack = attack;
+            ducking.release = release;
+            return;
+        }
+    }
+    _duckings.push_back({ trigger, gain, attack, release });
+    _hierarchy_changed = true;
+}
+
+
+void Bus::stopDucking(std::string const& trigger)
+{
+    _internal::TraceCall const trace(TraceOp::BusStopDucking, _name, trigger);
+    std::lock_guard const lock(_internal::getMutex());
+    std::erase_if(_duckings, [&](Ducking const& ducking) { return ducking.trigger == trigger; });
+    _gains_changed = true;
+    _internal::updateBuses();
+}
+
+
+void Bus::setEffectSlot(uint32_t slot_id)
+{
+    _internal::TraceCall const trace(TraceOp::BusSetEffectSlot, _name, slot_id);
+    std::lock_guard const lock(_internal::getMutex());
+    _effect_slot = slot_id;
+    for (Source* source : _getSources()) {
+        source->_applyBusEffectSlot();
+    }
+}
+
+
+void Bus::clearEffectSlot()
+{
+    _internal::TraceCall const trace(TraceOp::BusClearEffectSlot, _name);
+    std::lock_guard const lock(_internal::getMutex());
+    _effect_slot.reset();
+    for (Source* source : _getSources()) {
+        source->_applyBusEffectSlot();
+    }
+}
+
+
+std::optional<uint32_t> Bus::getInheritedEffectSlot() const noexcept
+{
+    for (Bus const* bus = this; bus != nullptr; bus = get(bus->_parent)) {
+        if (bus->_effect_slot)
+            return bus->_effect_slot;
+    }
+    return std::nullopt;
+}
+
+
+bool Bus::isWithin(std::string const& name) const noexcept
+{
+    for (Bus const* bus = this; bus != nullptr; bus = get(bus->_parent)) {
+        if (bus->_name == name)
+            return true;
+    }
+    return false;
+}
+
+
+std::vector<Source*> Bus::_getSources() const
+{
+    std::vector<Source*> sources;
+    for (auto const& source : Source::getArray()) {
+        if (!source || source->_bus.empty())
+            continue;
+        Bus const* bus = get(source->_bus);
+        if (bus && bus->isWithin(_name)) {
+            sources.push_back(source.get());
+        }
+    }
+    return sources;
+}
+
+
+void Bus::_resumeSources(std::vector<uint32_t> const& ids)
+{
+    // Batched per context, as OpenAL sources only exist within theirs
+    std::array<std::vector<ALuint>, _internal::max_contexts> openal_ids;
+    for (uint32_t const id : ids) {
+        Source* source = Source::get(id);
+        if (!source || !source->isPaused())
+            continue;
+        // Stay paused if a parent bus still is
+        if (Bus* pausing = source->_getPausingBus()) {
+            pausing->_paused_sources.push_back(id);
+        }
+        else {
+            openal_ids[source->_context_id].push_back(source->_openal_id);
+        }
+    }
+    for (uint32_t i = 0; i < openal_ids.size(); ++i) {
+        if (!openal_ids[i].empty()) {
+            _internal::bindContext(i);
+            alSourcePlayv(static_cast<ALsizei>(openal_ids[i].size()), openal_ids[i].data());
+        }
+    }
+}
+
+
+
+INTERNAL_BEGIN;
+
+using Clock = std::chrono::steady_clock;
+
+void updateBuses()
+{
+    static Clock::time_point last_update = Clock::now();
+    std::lock_guard const lock(getMutex());
+
+    Clock::time_point const now = Clock::now();
+    float const dt = std::chrono::duration<float>(now - last_update).count();
+    last_update = now;
+
+    auto const& buses = Bus::getMap();
+    auto const& sources = Source::getArray();
+
+    // Resolve names once, so that ticks only follow pointers
+    if (Bus::_hierarchy_changed) {
+        for (auto const& [name, bus] : buses) {
+            bus->_parent_bus = bus->_parent.empty() ? nullptr : Bus::get(bus->_parent);
+            for (Bus::Ducking& ducking : bus->_duckings) {
+                ducking.trigger_bus = Bus::get(ducking.trigger);
+            }
+        }
+        Bus::_source_buses.assign(sources.size(), nullptr);
+        for (size_t i = 0; i < sources.size(); ++i) {
+            if (sources[i] && !sources[i]->_bus.empty()) {
+                Bus::_source_buses[i] = Bus::get(sources[i]->_bus);
+            }
+        }
+        Bus::_hierarchy_changed = false;
+        Bus::_gains_changed = true;
+    }
+
+    // Which buses have a playing Source, directly or within their children
+    for (auto const& [name, bus] : buses) {
+        bus->_triggered = false;
+    }
+    for (size_t i = 0; i < sources.size(); ++i) {
+        if (!sources[i] || sources[i]->_bus.empty() || sources[i]->_last_state != AL_PLAYING)
+            continue;
+        for (Bus* it = Bus::_source_buses[i]; it != nullptr && !it->_triggered; it = it->_parent_bus) {
+            it->_triggered = true;
+        }
+    }
+
+    // Advance ducking envelopes, compute local gains
+    for (auto const& [name, bus] : buses) {
+        float gain = bus->_muted ? 0.f : bus->_gain;
+        for (Bus::Ducking& ducking : bus->_duckings) {
+            bool const active = ducking.trigger_bus && ducking.trigger_bus->_triggered;
+            float const target = active ? ducking.gain : 1.f;
+            float const tau = active ? ducking.attack : ducking.release;
+            float const k = tau > 0.f ? 1.f - std::exp(-dt / tau) : 1.f;
+            ducking.current += (target - ducking.current) * k;
+            gain *= ducking.current;
+        }
+        if (gain != bus->_local_gain) {
+            bus->_local_gain = gain;
+            Bus::_gains_changed = true;
+        }
+    }
+    if (!Bus::_gains_changed)
+        return;
+    Bus::_gains_changed = false;
+
+    // Effective gains include every parent
+    for (auto const& [name, bus] : buses) {
+        float gain = 1.f;
+        for (Bus const* it = bus.get(); it != nullptr; it = it->_parent_bus) {
+            gain *= it->_local_gain;
+        }
+        bus->_effective_gain = gain;
+    }
+
+    // Only touch Sources whose bus gain changed, applying all gains at once
+    DeferredUpdates batch;
+    for (size_t i = 0; i < sources.size(); ++i) {
+        if (!sources[i])
+            continue;
+        Bus const* bus = sources[i]->_bus.empty() ? nullptr : Bus::_source_buses[i];
+        float const gain = bus ? bus->_effective_gain : 1.f;
+        if (gain != sources[i]->_bus_gain) {
+            sources[i]->_bus_gain = gain;
+            sources[i]->_bind();
+            batch.add(sources[i]->_context_id);
+            sources[i]->_applyGain();
+        }
+    }
+}
+
+INTERNAL_END;
+
+SSS_AUDIO_END;
\ No newline at end of file
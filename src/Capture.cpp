@@ -0,0 +1,207 @@
+#include "Audio/Capture.hpp"
+#include "Audio/Decoder.hpp"
+
+SSS_AUDIO_BEGIN;
+
+std::map<uint32_t, std::unique_ptr<Capture>> Capture::_instances{};
+
+
+static size_t _getCapacity(CaptureSettings const& settings)
+{
+    int const frames = settings.buffer_frames > 0
+        ? settings.buffer_frames : std::max(settings.period_frames, 1) * 32;
+    return static_cast<size_t>(frames) * std::clamp(settings.channels, 1, 2);
+}
+
+
+Capture::Capture(uint32_t id, CaptureSettings const& settings)
+    : _map_id(id), _settings(settings), _ring(_getCapacity(settings))
+{
+    ALenum const format = _internal::getFormat(_settings.channels);
+    // The device's own buffer holds a few periods, the ring holds the rest
+    ALCsizei const device_frames = std::max(_settings.period_frames, 1) * 4;
+    _device = alcCaptureOpenDevice(_settings.device.empty() ? nullptr : _settings.device.c_str(),
+        static_cast<ALCuint>(_settings.frequency), format, device_frames);
+    if (_device == nullptr) {
+        SSS::throw_exc("Couldn't open capture device: " + _internal::getALErrorString(alcGetError(nullptr)));
+    }
+}
+
+
+Capture::~Capture()
+{
+    stop();
+    if (_device != nullptr) {
+        alcCaptureCloseDevice(_device);
+    }
+}
+
+
+Capture& Capture::create(uint32_t id, CaptureSettings const& settings) try
+{
+    std::lock_guard const lock(_internal::getMutex());
+    _instances[id].reset(new Capture(id, settings));
+    return *_instances.at(id);
+}
+CATCH_AND_RETHROW_FUNC_EXC;
+
+
+Capture& Capture::create(CaptureSettings const& settings) try
+{
+    std::lock_guard const lock(_internal::getMutex());
+    uint32_t id = 0;
+    // Increment ID until no similar value is found
+    while (_instances.count(id) != 0) {
+        ++id;
+    }
+    return create(id, settings);
+}
+CATCH_AND_RETHROW_FUNC_EXC;
+
+
+Capture* Capture::get(uint32_t id) noexcept
+{
+    auto const it = _instances.find(id);
+    if (it == _instances.cend())
+        return nullptr;
+    return it->second.get();
+}
+
+
+void Capture::remove(uint32_t id)
+{
+    std::lock_guard const lock(_internal::getMutex());
+    _instances.erase(id);
+}
+
+
+void Capture::clearAll() noexcept
+{
+    std::lock_guard const lock(_internal::getMutex());
+    _instances.clear();
+}
+
+
+std::vector<std::string> Capture::getDevices()
+{
+    std::vector<std::string> devices;
+    // List of null-terminated strings
+    ALCchar const* device = alcGetString(nullptr, ALC_CAPTURE_DEVICE_SPECIFIER);
+    while (device && *device != '\0') {
+        devices.emplace_back(device);
+        device += devices.back().size() + 1;
+    }
+    return devices;
+}
+
+
+void Capture::start()
+{
+    if (_running)
+        return;
+    // Left joinable when the thread stopped on its own (disconnection)
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+    _running = true;
+    alcCaptureStart(_device);
+    _thread = std::thread(&Capture::_run, this);
+}
+
+
+void Capture::stop()
+{
+    if (!_running && !_thread.joinable())
+        return;
+    _running = false;
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+    alcCaptureStop(_device);
+}
+
+
+CaptureView Capture::peek() const noexcept
+{
+    auto const spans = _ring.readable();
+    return CaptureView{ spans[0], spans[1] };
+}
+
+
+void Capture::consume(size_t frames) noexcept
+{
+    size_t const channels = static_cast<size_t>(_settings.channels);
+    _ring.release(std::min(frames * channels, _ring.size()));
+}
+
+
+size_t Capture::read(short* samples, size_t frames) noexcept
+{
+    size_t const channels = static_cast<size_t>(_settings.channels);
+    size_t count = 0;
+    for (std::span<short const> const span : _ring.readable()) {
+        size_t const copied = std::min(span.size(), frames * channels - count);
+        std::copy_n(span.data(), copied, samples + count);
+        count += copied;
+    }
+    _ring.release(count);
+    return count / channels;
+}
+
+
+void Capture::flush() noexcept
+{
+    _ring.release(_ring.size());
+}
+
+
+void Capture::_run()
+{
+    size_t const channels = static_cast<size_t>(_settings.channels);
+    ALCint const period = std::max(_settings.period_frames, 1);
+    // Wake up a few times per period to keep latency low
+    auto const sleep = std::chrono::microseconds(
+        std::max<int64_t>(1000000LL * period / std::max(_settings.frequency, 1) / 4, 250));
+    bool const can_disconnect = alcIsExtensionPresent(_device, "ALC_EXT_disconnect") == ALC_TRUE;
+    // The device holds 4 periods: past 2 the ring can't take, the excess is
+    // dropped here, before the device overwrites anything
+    ALCint const drop_threshold = period * 2;
+    std::vector<short> scratch(static_cast<size_t>(period) * 4 * channels);
+
+    while (_running) {
+        ALCint available = 0;
+        alcGetIntegerv(_device, ALC_CAPTURE_SAMPLES, 1, &available);
+        if (available >= period) {
+            // Captured straight into the ring's free space
+            size_t remaining = static_cast<size_t>(available);
+            for (std::span<short> const span : _ring.writable()) {
+                size_t const frames = std::min(span.size() / channels, remaining);
+                if (frames == 0)
+                    continue;
+                alcCaptureSamples(_device, span.data(), static_cast<ALCsizei>(frames));
+                _ring.commit(frames * channels);
+                remaining -= frames;
+            }
+            if (remaining >= static_cast<size_t>(drop_threshold)) {
+                for (size_t dropped = 0; dropped < remaining;) {
+                    size_t const frames = std::min(remaining - dropped, scratch.size() / channels);
+                    alcCaptureSamples(_device, scratch.data(), static_cast<ALCsizei>(frames));
+                    dropped += frames;
+                }
+                _overruns += remaining;
+            }
+        }
+        else if (can_disconnect) {
+            ALCint connected = ALC_TRUE;
+            alcGetIntegerv(_device, ALC_CONNECTED, 1, &connected);
+            if (connected == ALC_FALSE) {
+                LOG_CTX_WRN("SSS/Audio", CONTEXT_MSG("Capture device disconnected", _map_id));
+                _running = false;
+                break;
+            }
+        }
+        std::this_thread::sleep_for(sleep);
+    }
+}
+
+SSS_AUDIO_END;
\ No newline at end of file
@@ -0,0 +1,275 @@
+#include "Audio/Compression.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <thread>
+
+SSS_AUDIO_BEGIN;
+INTERNAL_BEGIN;
+
+static constexpr int _ima4_steps[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+    11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+    32767
+};
+static constexpr int _ima4_codewords[16] = {
+    1, 3, 5, 7, 9, 11, 13, 15, -1, -3, -5, -7, -9, -11, -13, -15
+};
+static constexpr int _ima4_index_adjust[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+static constexpr int _msadpcm_coefficients[7][2] = {
+    { 256, 0 }, { 512, -256 }, { 0, 0 }, { 192, 64 }, { 240, 0 }, { 460, -208 }, { 392, -232 }
+};
+static constexpr int _msadpcm_adaptation[16] = {
+    230, 230, 230, 230, 307, 409, 512, 614, 768, 614, 512, 409, 307, 230, 230, 230
+};
+
+
+static inline int _clampSample(int sample) noexcept
+{
+    return std::clamp(sample, -32768, 32767);
+}
+
+
+static inline void _writeShort(uint8_t* dst, int value) noexcept
+{
+    dst[0] = static_cast<uint8_t>(value & 0xff);
+    dst[1] = static_cast<uint8_t>((value >> 8) & 0xff);
+}
+
+
+// Reads one channel of a block, padding the last one with silence
+static void _readBlock(std::vector<int>& dst, short const* samples, size_t frames,
+    int channels, int channel, size_t first, int block_frames)
+{
+    dst.resize(block_frames);
+    for (int i = 0; i < block_frames; ++i) {
+        size_t const frame = first + i;
+        dst[i] = frame < frames ? samples[frame * channels + channel] : 0;
+    }
+}
+
+
+// Helper threads encoding blocks, shared by Buffers loading concurrently
+static std::atomic<size_t> _busy_workers{ 0 };
+
+// Runs func(block, scratch) for every block, split in ranges across hardware
+// threads. Scratch is constructed once per range & reused by its blocks.
+// Small inputs, or ones loaded while every thread is busy, run serially.
+template<typename Scratch, typename Func>
+static void _forEachBlock(size_t count, Func const& func)
+{
+    auto const run = [&func](size_t first, size_t last) {
+        Scratch scratch;
+        for (size_t block = first; block < last; ++block) {
+            func(block, scratch);
+        }
+    };
+    size_t constexpr min_blocks = 1024; // Not worth a thread below
+    size_t const max_workers = std::max(std::thread::hardware_concurrency(), 1u) - 1;
+    size_t const wanted = std::min(count / min_blocks, max_workers + 1);
+    // Reserve helpers from the shared budget, the calling thread taking one range
+    size_t helpers = 0;
+    size_t busy = _busy_workers.load(std::memory_order_relaxed);
+    do {
+        helpers = std::min(wanted > 0 ? wanted - 1 : 0, max_workers - std::min(busy, max_workers));
+    } while (helpers != 0 && !_busy_workers.compare_exchange_weak(busy, busy + helpers));
+    struct Release {
+        size_t count;
+        ~Release() { _busy_workers.fetch_sub(count); }
+    } const release{ helpers };
+
+    size_t const per_range = (count + helpers) / (helpers + 1);
+    std::vector<std::future<void>> tasks;
+    tasks.reserve(helpers);
+    for (size_t first = per_range; first < count; first += per_range) {
+        tasks.push_back(std::async(std::launch::async, run, first, std::min(first + per_range, count)));
+    }
+    run(0, std::min(per_range, count));
+    for (auto& task : tasks) {
+        task.get();
+    }
+}
+
+
+bool isSupported(Compression::Format format) noexcept
+{
+    switch (format) {
+    case Compression::Format::PCM16:
+        return true;
+    case Compression::Format::IMA4:
+        return alIsExtensionPresent("AL_EXT_IMA4") == AL_TRUE;
+    case Compression::Format::MSADPCM:
+        return alIsExtensionPresent("AL_SOFT_MSADPCM") == AL_TRUE;
+    }
+    return false;
+}
+
+
+Encoded encodeIMA4(short const* samples, size_t frames, int channels, int block_frames)
+{
+    // Header sample + groups of 8 samples per channel
+    block_frames = block_frames > 1 ? ((block_frames - 1) / 8) * 8 + 1 : 65;
+    block_frames = std::max(block_frames, 9);
+    size_t const block_bytes = channels * (4 + (block_frames - 1) / 2);
+    size_t const block_count = (frames + block_frames - 1) / block_frames;
+
+    Encoded encoded;
+    encoded.format = channels == 1 ? AL_FORMAT_MONO_IMA4 : AL_FORMAT_STEREO_IMA4;
+    encoded.block_frames = block_frames;
+    encoded.data.resize(block_count * block_bytes);
+
+    struct Scratch {
+        std::vector<int> input;
+        std::vector<uint8_t> nibbles;
+    };
+    _forEachBlock<Scratch>(block_count, [&](size_t block, Scratch& scratch) {
+        std::vector<int>& input = scratch.input;
+        std::vector<uint8_t>& nibbles = scratch.nibbles;
+        nibbles.resize(block_frames - 1);
+        uint8_t* const dst = encoded.data.data() + block * block_bytes;
+        for (int c = 0; c < channels; ++c) {
+            _readBlock(input, samples, frames, channels, c, block * block_frames, block_frames);
+            // Blocks are independent: the step index is estimated from the
+            // first differences instead of carried from the previous block
+            int max_diff = 0;
+            for (int i = 1; i < std::min(block_frames, 5); ++i) {
+                max_diff = std::max(max_diff, std::abs(input[i] - input[i - 1]));
+            }
+            int index = 0;
+            while (index < 88 && _ima4_steps[index] < max_diff) {
+                ++index;
+            }
+            int sample = input[0];
+            _writeShort(dst + c * 4, sample);
+            dst[c * 4 + 2] = static_cast<uint8_t>(index);
+            dst[c * 4 + 3] = 0;
+
+            for (int i = 1; i < block_frames; ++i) {
+                int const step = _ima4_steps[index];
+                int const diff = input[i] - sample;
+                int nibble = std::min(std::abs(diff) * 4 / step, 7);
+                if (diff < 0) {
+                    nibble |= 8;
+                }
+                // Decode exactly like the mixer to stay in sync
+                sample = _clampSample(sample + step * _ima4_codewords[nibble] / 8);
+                index = std::clamp(index + _ima4_index_adjust[nibble], 0, 88);
+                nibbles[i - 1] = static_cast<uint8_t>(nibble);
+            }
+            // Groups of 8 samples (4 bytes) per channel, low nibble first
+            for (int group = 0; group < (block_frames - 1) / 8; ++group) {
+                uint8_t* word = dst + channels * 4 + (group * channels + c) * 4;
+                for (int i = 0; i < 4; ++i) {
+                    word[i] = static_cast<uint8_t>(nibbles[group * 8 + i * 2]
+                        | (nibbles[group * 8 + i * 2 + 1] << 4));
+                }
+            }
+        }
+    });
+    return encoded;
+}
+
+
+Encoded encodeMSADPCM(short const* samples, size_t frames, int channels, int block_frames)
+{
+    // Two header samples + nibble pairs
+    block_frames = block_frames > 2 ? block_frames & ~1 : 64;
+    block_frames = std::max(block_frames, 4);
+    size_t const block_bytes = channels * 7 + (block_frames - 2) * channels / 2;
+    size_t const block_count = (frames + block_frames - 1) / block_frames;
+
+    Encoded encoded;
+    encoded.format = channels == 1 ? AL_FORMAT_MONO_MSADPCM_SOFT : AL_FORMAT_STEREO_MSADPCM_SOFT;
+    encoded.block_frames = block_frames;
+    encoded.data.resize(block_count * block_bytes);
+
+    // Encodes one channel of a block with given predictor, returns the squared error
+    auto const encode = [block_frames](std::vector<int> const& input, int predictor,
+        int delta, uint8_t* nibbles)
+    {
+        int const coef1 = _msadpcm_coefficients[predictor][0];
+        int const coef2 = _msadpcm_coefficients[predictor][1];
+        int sample1 = input[1], sample2 = input[0];
+        int64_t error = 0;
+        for (int i = 2; i < block_frames; ++i) {
+            int const prediction = (sample1 * coef1 + sample2 * coef2) / 256;
+            int const diff = input[i] - prediction;
+            // Rounded to nearest
+            int const rounded = (diff >= 0 ? diff + delta / 2 : diff - delta / 2) / delta;
+            int const nibble = std::clamp(rounded, -8, 7);
+            // Decode exactly like the mixer to stay in sync
+            int const sample = _clampSample(prediction + nibble * delta);
+            error += static_cast<int64_t>(input[i] - sample) * (input[i] - sample);
+            sample2 = sample1;
+            sample1 = sample;
+            delta = std::max((_msadpcm_adaptation[nibble & 0xf] * delta) / 256, 16);
+            if (nibbles) {
+                nibbles[i - 2] = static_cast<uint8_t>(nibble & 0xf);
+            }
+        }
+        return error;
+    };
+
+    struct Scratch {
+        std::vector<int> input;
+        std::vector<uint8_t> nibbles;
+        std::vector<uint8_t> channel_nibbles;
+    };
+    _forEachBlock<Scratch>(block_count, [&](size_t block, Scratch& scratch) {
+        std::vector<int>& input = scratch.input;
+        std::vector<uint8_t>& nibbles = scratch.nibbles;
+        std::vector<uint8_t>& channel_nibbles = scratch.channel_nibbles;
+        nibbles.resize(static_cast<size_t>(block_frames - 2) * channels);
+        channel_nibbles.resize(block_frames - 2);
+        uint8_t* const dst = encoded.data.data() + block * block_bytes;
+        for (int c = 0; c < channels; ++c) {
+            _readBlock(input, samples, frames, channels, c, block * block_frames, block_frames);
+            // Keep the predictor with the lowest error
+            int best_predictor = 0, best_delta = 16;
+            int64_t best_error = std::numeric_limits<int64_t>::max();
+            for (int predictor = 0; predictor < 7; ++predictor) {
+                int const coef1 = _msadpcm_coefficients[predictor][0];
+                int const coef2 = _msadpcm_coefficients[predictor][1];
+                // Initial delta from the first residuals
+                int64_t residuals = 0;
+                int const count = std::min(block_frames - 2, 8);
+                for (int i = 2; i < 2 + count; ++i) {
+                    residuals += std::abs(input[i] - (input[i - 1] * coef1 + input[i - 2] * coef2) / 256);
+                }
+                int const delta = std::clamp(static_cast<int>(residuals / count / 4), 16, 32767);
+                int64_t const error = encode(input, predictor, delta, nullptr);
+                if (error < best_error) {
+                    best_error = error;
+                    best_predictor = predictor;
+                    best_delta = delta;
+                }
+            }
+            encode(input, best_predictor, best_delta, channel_nibbles.data());
+            for (int i = 0; i < block_frames - 2; ++i) {
+                nibbles[i * channels + c] = channel_nibbles[i];
+            }
+            // Predictors, deltas, then second & first samples, per channel
+            dst[c] = static_cast<uint8_t>(best_predictor);
+            _writeShort(dst + channels + c * 2, best_delta);
+            _writeShort(dst + channels * 3 + c * 2, input[1]);
+            _writeShort(dst + channels * 5 + c * 2, input[0]);
+        }
+        // Interleaved nibbles, high nibble first
+        uint8_t* const data = dst + channels * 7;
+        for (size_t i = 0; i < nibbles.size(); i += 2) {
+            data[i / 2] = static_cast<uint8_t>((nibbles[i] << 4) | nibbles[i + 1]);
+        }
+    });
+    return encoded;
+}
+
+INTERNAL_END;
+SSS_AUDIO_END;
\ No newline at end of file
@@ -0,0 +1,302 @@
+#include "Audio/Decoder.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+
+SSS_AUDIO_BEGIN;
+INTERNAL_BEGIN;
+
+using Clock = std::chrono::steady_clock;
+
+// Default backend
+class SndfileDecoder final : public Decoder {
+public:
+    ~SndfileDecoder()
+    {
+        if (_file != nullptr) {
+            sf_close(_file);
+        }
+    }
+
+    bool open(std::string const& filename) override
+    {
+        _file = sf_open(filename.c_str(), SFM_READ, &_infos);
+        return _file != nullptr;
+    }
+
+    AudioInfo getInfo() const noexcept override
+    {
+        return AudioInfo{ _infos.channels, _infos.samplerate, static_cast<int64_t>(_infos.frames) };
+    }
+
+    size_t read(short* samples, size_t frames) override
+    {
+        sf_count_t const read = sf_readf_short(_file, samples, static_cast<sf_count_t>(frames));
+        return read > 0 ? static_cast<size_t>(read) : 0;
+    }
+
+    bool seek(int64_t frame) override
+    {
+        return sf_seek(_file, static_cast<sf_count_t>(frame), SEEK_SET) >= 0;
+    }
+
+    // WAV SMPL & AIFF INST chunks, libsndfile giving an exclusive end
+    std::optional<LoopPoints> getLoopPoints() const override
+    {
+        SF_INSTRUMENT instrument{};
+        if (sf_command(_file, SFC_GET_INSTRUMENT, &instrument, sizeof(instrument)) != SF_TRUE
+            || instrument.loop_count < 1 || instrument.loops[0].mode == SF_LOOP_NONE)
+        {
+            return std::nullopt;
+        }
+        return LoopPoints{ instrument.loops[0].start, instrument.loops[0].end };
+    }
+
+private:
+    SNDFILE* _file{ nullptr };
+    SF_INFO _infos{};
+};
+
+
+struct Backend {
+    std::string name;
+    std::vector<std::string> extensions;
+    DecoderFactory factory;
+};
+
+static std::mutex _mutex;
+
+// Most recently registered first
+static std::vector<Backend>& _getBackends()
+{
+    static std::vector<Backend> backends{
+        { "sndfile", { "*" }, []() { return std::make_unique<SndfileDecoder>(); } }
+    };
+    return backends;
+}
+
+static std::map<std::pair<std::string, std::string>, DecoderStats> _stats;
+
+
+static std::string _getExtension(std::string const& filename)
+{
+    std::string ext = std::filesystem::path(filename).extension().string();
+    if (!ext.empty() && ext[0] == '.') {
+        ext.erase(0, 1);
+    }
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return ext;
+}
+
+
+static void _report(std::string const& name, std::string const& extension, uint64_t frames, double seconds)
+{
+    std::lock_guard const lock(_mutex);
+    DecoderStats& stats = _stats[{ name, extension }];
+    stats.name = name;
+    stats.extension = extension;
+    stats.frames += frames;
+    stats.seconds += seconds;
+}
+
+
+DecoderHandle::DecoderHandle(std::unique_ptr<Decoder> decoder, std::string name, std::string extension)
+    : _decoder(std::move(decoder)), _name(std::move(name)), _extension(std::move(extension))
+{
+}
+
+
+DecoderHandle::~DecoderHandle()
+{
+    if (_frames != 0) {
+        _report(_name, _extension, _frames, _seconds);
+    }
+}
+
+
+size_t DecoderHandle::read(short* samples, size_t frames)
+{
+    Clock::time_point const start = Clock::now();
+    size_t const read = _decoder->read(samples, frames);
+    _seconds += std::chrono::duration<double>(Clock::now() - start).count();
+    _frames += read;
+    // Report by large chunks to keep the lock out of small reads
+    if (_frames >= (1u << 20)) {
+        _report(_name, _extension, _frames, _seconds);
+        _frames = 0;
+        _seconds = 0.;
+    }
+    return read;
+}
+
+
+std::optional<LoopPoints> DecoderHandle::getLoopPoints() const
+{
+    std::optional<LoopPoints> loop = _decoder->getLoopPoints();
+    if (!loop)
+        return loop;
+    int64_t const frames = getInfo().frames;
+    if (loop->start < 0 || loop->end <= loop->start || (frames > 0 && loop->end > frames)) {
+        LOG_CTX_WRN("SSS/Audio", CONTEXT_MSG("Ignoring invalid loop points", _name));
+        return std::nullopt;
+    }
+    return loop;
+}
+
+
+ALenum getFormat(int channels)
+{
+    switch (channels) {
+    case 1:
+        return AL_FORMAT_MONO16;
+    case 2:
+        return AL_FORMAT_STEREO16;
+    default:
+        SSS::throw_exc(CONTEXT_MSG("Unsupported channel count", channels));
+    }
+    return 0;
+}
+
+
+std::unique_ptr<DecoderHandle> openDecoder(std::string const& filename)
+{
+    std::string const ext = _getExtension(filename);
+
+    // Candidates & their measured speed, -1 when not measured yet
+    std::vector<std::pair<Backend, double>> candidates;
+    {
+        std::lock_guard const lock(_mutex);
+        for (Backend const& backend : _getBackends()) {
+            auto const& exts = backend.extensions;
+            if (std::find(exts.cbegin(), exts.cend(), ext) == exts.cend()
+                && std::find(exts.cbegin(), exts.cend(), "*") == exts.cend())
+            {
+                continue;
+            }
+            auto const it = _stats.find({ backend.name, ext });
+            double const speed = (it != _stats.cend() && it->second.frames != 0)
+                ? it->second.framesPerSecond() : -1.;
+            candidates.emplace_back(backend, speed);
+        }
+    }
+    // Unmeasured first (registration order), then fastest
+    std::stable_sort(candidates.begin(), candidates.end(), [](auto const& a, auto const& b) {
+        if ((a.second < 0.) != (b.second < 0.))
+            return a.second < 0.;
+        return a.second > b.second;
+    });
+
+    for (auto const& [backend, speed] : candidates) {
+        try {
+            std::unique_ptr<Decoder> decoder = backend.factory();
+            if (decoder && decoder->open(filename)) {
+                return std::make_unique<DecoderHandle>(std::move(decoder), backend.name, ext);
+            }
+        }
+        catch (std::exception const& e) {
+            LOG_CTX_WRN("SSS/Audio", CONTEXT_MSG(backend.name + " couldn't decode file", e.what()));
+        }
+    }
+    SSS::throw_exc("Couldn't open " + filename);
+    return nullptr;
+}
+
+INTERNAL_END;
+
+
+void registerDecoder(std::string const& name,
+    std::vector<std::string> const& extensions, DecoderFactory factory)
+{
+    std::lock_guard const lock(_internal::_mutex);
+    auto& backends = _internal::_getBackends();
+    std::erase_if(backends, [&](_internal::Backend const& b) { return b.name == name; });
+    std::erase_if(_internal::_stats, [&](auto const& pair) { return pair.first.first == name; });
+    backends.insert(backends.begin(), _internal::Backend{ name, extensions, std::move(factory) });
+}
+
+
+void unregisterDecoder(std::string const& name)
+{
+    std::lock_guard const lock(_internal::_mutex);
+    std::erase_if(_internal::_getBackends(), [&](_internal::Backend const& b) { return b.name == name; });
+}
+
+
+std::vector<std::string> getDecoders()
+{
+    std::lock_guard const lock(_internal::_mutex);
+    std::vector<std::string> names;
+    for (auto const& backend : _internal::_getBackends()) {
+        names.push_back(backend.name);
+    }
+    return names;
+}
+
+
+std::vector<DecoderStats> getDecoderStats()
+{
+    std::lock_guard const lock(_internal::_mutex);
+    std::vector<DecoderStats> stats;
+    stats.reserve(_internal::_stats.size());
+    for (auto const& pair : _internal::_stats) {
+        stats.push_back(pair.second);
+    }
+    return stats;
+}
+
+
+std::vector<DecoderBenchmark> benchmarkDecoders(std::string const& filename, int runs) try
+{
+    std::string const ext = _internal::_getExtension(filename);
+    std::vector<_internal::Backend> backends;
+    {
+        std::lock_guard const lock(_internal::_mutex);
+        backends = _internal::_getBackends();
+    }
+
+    std::vector<DecoderBenchmark> results;
+    std::vector<short> samples;
+    for (_internal::Backend const& backend : backends) {
+        DecoderBenchmark& result = results.emplace_back();
+        result.name = backend.name;
+        double total_ms = 0.;
+        AudioInfo info;
+        for (int run = 0; run < std::max(runs, 1); ++run) {
+            std::unique_ptr<Decoder> decoder = backend.factory();
+            if (!decoder || !decoder->open(filename))
+                break;
+            // Failed runs are left out of the average
+            try {
+                info = decoder->getInfo();
+                size_t constexpr chunk = 4096;
+                samples.resize(chunk * std::max(info.channels, 1));
+                uint64_t frames = 0;
+                auto const start = std::chrono::steady_clock::now();
+                while (size_t const read = decoder->read(samples.data(), chunk)) {
+                    frames += read;
+                }
+                double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                _internal::_report(backend.name, ext, frames, seconds);
+                total_ms += seconds * 1000.;
+                ++result.runs;
+            }
+            catch (std::exception const& e) {
+                LOG_CTX_WRN("SSS/Audio", CONTEXT_MSG(backend.name + " failed a benchmark run", e.what()));
+            }
+        }
+        // Backends without a single successful run are reported as failed
+        result.supported = result.runs > 0;
+        if (result.supported) {
+            result.decode_ms = total_ms / result.runs;
+            double const duration_ms = info.sample_rate > 0
+                ? 1000. * static_cast<double>(info.frames) / info.sample_rate : 0.;
+            result.realtime_factor = result.decode_ms > 0. ? duration_ms / result.decode_ms : 0.;
+        }
+    }
+    return results;
+}
+CATCH_AND_RETHROW_FUNC_EXC;
+
+SSS_AUDIO_END;
\ No newline at end of file
@@ -1,13 +1,48 @@
 #define SSS_LUA
 #include "Audio.hpp"
 
-int main() try
+#include <cstdio>
+#include <cstring>
+
+// Prints the timings of a trace replayed on a loopback device
+static void replay(char const* filename)
+{
+    SSS::Audio::ReplayStats const stats = SSS::Audio::replayTrace(filename);
+    std::printf("%llu events, %.1fms of trace replayed in %.1fms (x%.1f)\n",
+        static_cast<unsigned long long>(stats.events), stats.trace_ms, stats.wall_ms, stats.speedup());
+    std::printf("calls %.1fms, render %.1fms, update %.1fms\n",
+        stats.calls_ms, stats.render_ms, stats.update_ms);
+    if (stats.skipped != 0) {
+        std::printf("%llu events skipped, their Source or Buffer predating the recording\n",
+            static_cast<unsigned long long>(stats.skipped));
+    }
+    if (stats.counts_allocations) {
+        std::printf("%llu allocations, %llu bytes\n",
+            static_cast<unsigned long long>(stats.allocations),
+            static_cast<unsigned long long>(stats.allocated_bytes));
+    }
+    for (SSS::Audio::TraceOpStats const& op : stats.ops) {
+        std::printf("%-24s %8llu calls %10.1fus total %8.1fus max %8llu allocs\n", op.name.c_str(),
+            static_cast<unsigned long long>(op.count), op.total_us, op.max_us,
+            static_cast<unsigned long long>(op.allocations));
+    }
+}
+
+// Runs Demo.lua, or Benchmark.lua with the "bench" argument,
+// or replays a trace with "replay <file>"
+int main(int argc, char** argv) try
 {
+    if (argc > 2 && std::strcmp(argv[1], "replay") == 0) {
+        replay(argv[2]);
+        SSS::Audio::terminate();
+        return 0;
+    }
+    bool const bench = argc > 1 && std::strcmp(argv[1], "bench") == 0;
     sol::state lua;
-    lua.open_libraries(sol::lib::base, sol::lib::string);
+    lua.open_libraries(sol::lib::base, sol::lib::string, sol::lib::os);
     SSS::Audio::lua_setup_Audio(lua);
     SSS::Audio::init();
-    lua.script_file("Demo.lua");
+    lua.script_file(bench ? "Benchmark.lua" : "Demo.lua");
     SSS::Audio::terminate();
 }
 CATCH_AND_LOG_FUNC_EXC;
\ No newline at end of file
@@ -1,13 +1,34 @@
 #include "Audio/Source.hpp"
 #include "Audio/Buffer.hpp"
+#include "Audio/Effect.hpp"
+#include "Audio/Analyzer.hpp"
+#include "Audio/Trace.hpp"
+
+#include <atomic>
+#include <future>
 
 SSS_AUDIO_BEGIN;
 INTERNAL_BEGIN;
 
+using Clock = std::chrono::steady_clock;
+
+struct ListenerState {
+    ALfloat gain;
+    std::array<ALfloat, 3> position;
+    std::array<ALfloat, 3> velocity;
+    std::array<ALfloat, 6> orientation;
+};
+
 class Device final {
     friend void ::SSS::Audio::init();
     friend void ::SSS::Audio::terminate();
     friend bool is_init() noexcept;
+    friend void checkDevice();
+    friend InitStats SSS::Audio::getInitStats() noexcept;
+    friend void bindContext(uint32_t context_id) noexcept;
+    friend bool hasContext(uint32_t context_id) noexcept;
+    friend DeferredUpdates;
+    friend EFXFunctions const* getEFX() noexcept;
 public:
     Device(const Device&) = delete; // Copy constructor
     Device(Device&&) = delete; // Move constructor
@@ -18,62 +39,398 @@ public:
     // Returns singleton
     static Device& get();
 
-    // Updates _all_devices
-    void updateDevices();
-    inline auto const& getAllDevices() const noexcept { return _all_devices; };
+    // Waits for the background enumeration if needed
+    std::unordered_map<std::string, std::string> getAllDevices();
     inline std::string getCurrentDevice() const noexcept { return _current_device; };
+    // Moves every Source & Buffer to given device, keeping playback positions
     void selectDevice(std::string const& name);
+    // Fails over to the default device if the current one was disconnected,
+    // or retries opening one if that failed
+    void checkConnection();
 
     void setMainVolume(int volume) noexcept;
     int getMainVolume() const noexcept;
 
+    bool renderMix(short* samples, size_t frames);
+    inline void setMixAnalyzer(std::optional<uint32_t> analyzer_id) noexcept { _mix_analyzer = analyzer_id; };
+
+    uint32_t createContext();
+    void removeContext(uint32_t context_id);
+    std::vector<uint32_t> getContexts() const;
+
+    // Stored until a device is opened if no device is
+    static void configure(DeviceSettings const& settings);
+    inline static DeviceSettings const& getSettings() noexcept { return _settings; };
+    DeviceInfo getInfo() const;
+    InitStats getInitStats();
+
 private:
     static std::unique_ptr<Device> _ptr;
+    // Set while constructed, as _ptr is already reset when destroying
+    static Device* _alive;
+    static DeviceSettings _settings;
     Device();
 
-    void _init(std::string const& name = "");
+    void _openDevice(char const* specifier);
+    // Main context, made current process-wide
+    void _createContext();
+    ALCcontext* _newContext() const;
+    // Resets the calling thread's context, invalidating every thread's binding
+    void _unbindContexts() noexcept;
+    void _open(char const* specifier);
+    void _close() noexcept;
+    void _switch(char const* specifier);
+    // Name of the opened device, as listed in _all_devices
+    std::string _getOpenedDevice() const;
+    // Retrieves the background enumeration result, if any
+    void _collectDevices();
+    // Zero-terminated ALC attribute list matching _settings
+    std::vector<ALCint> _getAttributes() const;
 
     // All devices listed by OpenAL
     std::unordered_map<std::string, std::string> _all_devices;
+    // Background enumeration, started once the default device is opened,
+    // along with its duration
+    std::future<std::pair<std::unordered_map<std::string, std::string>, double>> _enumeration;
+    std::mutex _devices_mutex;
+    InitStats _init_stats;
     // Current device name
     std::string _current_device;
     // Current OpenAL device
-    ALCdevice* _device;
-    // Current OpenAL context
-    ALCcontext* _context;
+    ALCdevice* _device{ nullptr };
+    // OpenAL contexts, 0 being the main one & nullptr free slots.
+    // Only accessed under the engine mutex, bindContext() included.
+    std::array<ALCcontext*, max_contexts> _contexts{};
+    // ALC_EXT_thread_local_context, if supported
+    PFNALCSETTHREADCONTEXTPROC _set_thread_context{ nullptr };
+    // Entry points of the current device, if it supports EFX
+    std::optional<EFXFunctions> _efx;
+    // AL_SOFT_deferred_updates, if supported
+    LPALDEFERUPDATESSOFT _defer_updates{ nullptr };
+    LPALPROCESSUPDATESSOFT _process_updates{ nullptr };
+    // Set for loopback devices only
+    LPALCRENDERSAMPLESSOFT _render_samples{ nullptr };
+    std::optional<uint32_t> _mix_analyzer;
+    // Bumped when contexts are destroyed, invalidating per-thread bindings
+    static std::atomic<uint64_t> _epoch;
+    // Duration of the last device switch
+    double _last_switch_ms{ 0. };
+    // Set when no device could be opened during a switch. Everything stays
+    // suspended, listeners included, until checkConnection() opens one.
+    bool _lost{ false };
+    Clock::time_point _retry_time;
+    std::array<std::optional<ListenerState>, max_contexts> _listeners;
+    static constexpr std::chrono::seconds _retry_period{ 1 };
 };
 
 std::unique_ptr<Device> Device::_ptr{};
+DeviceSettings Device::_settings{};
+std::atomic<uint64_t> Device::_epoch{ 1 };
+Device* Device::_alive{ nullptr };
+
+// Listener of the calling thread's context
+static ListenerState _getListener()
+{
+    ListenerState state;
+    alGetListenerf(AL_GAIN, &state.gain);
+    alGetListenerfv(AL_POSITION, state.position.data());
+    alGetListenerfv(AL_VELOCITY, state.velocity.data());
+    alGetListenerfv(AL_ORIENTATION, state.orientation.data());
+    return state;
+}
+
+
+static void _setListener(ListenerState const& state)
+{
+    alListenerf(AL_GAIN, state.gain);
+    alListenerfv(AL_POSITION, state.position.data());
+    alListenerfv(AL_VELOCITY, state.velocity.data());
+    alListenerfv(AL_ORIENTATION, state.orientation.data());
+}
+
+
+// Strips the "OpenAL Soft on " prefix from a device specifier
+static std::string _getDeviceKey(std::string const& specifier)
+{
+    std::string const needle("OpenAL Soft on ");
+    size_t const id = specifier.find(needle);
+    if (id != std::string::npos && id + needle.size() < specifier.size()) {
+        return specifier.substr(id + needle.size());
+    }
+    return specifier;
+}
+
 
-void Device::_init(std::string const& name)
+// Parses ALC_ALL_DEVICES_SPECIFIER, which can be slow as every
+// backend gets probed
+static std::unordered_map<std::string, std::string> _enumerateDevices()
 {
-    char const* id;
-    if (_all_devices.count(name) != 0) {
-        id = _all_devices.at(name).c_str();
-        _current_device = name;
+    std::unordered_map<std::string, std::string> devices;
+    if (alcIsExtensionPresent(NULL, "ALC_ENUMERATE_ALL_EXT") == ALC_TRUE) {
+        // Retrieve devices, as a list of null-terminated strings
+        ALCchar const* device = alcGetString(NULL, ALC_ALL_DEVICES_SPECIFIER);
+        // Add each device one by one
+        while (device && *device != '\0') {
+            std::string const specifier = device;
+            devices[_getDeviceKey(specifier)] = specifier;
+            device += specifier.size() + 1;
+        }
+    }
+    return devices;
+}
+
+
+void Device::_openDevice(char const* specifier)
+{
+    _render_samples = nullptr;
+    if (_settings.loopback) {
+        if (alcIsExtensionPresent(nullptr, "ALC_SOFT_loopback") != ALC_TRUE) {
+            SSS::throw_exc("ALC_SOFT_loopback isn't supported, can't open a loopback device.");
+        }
+        auto const open = reinterpret_cast<LPALCLOOPBACKOPENDEVICESOFT>(
+            alcGetProcAddress(nullptr, "alcLoopbackOpenDeviceSOFT"));
+        _render_samples = reinterpret_cast<LPALCRENDERSAMPLESSOFT>(
+            alcGetProcAddress(nullptr, "alcRenderSamplesSOFT"));
+        _device = open ? open(nullptr) : nullptr;
     }
     else {
-        id = _all_devices.cbegin()->second.c_str();
-        _current_device = _all_devices.cbegin()->first;
+        _device = alcOpenDevice(specifier);
     }
-    _device = alcOpenDevice(id);
     if (_device == nullptr) {
         SSS::throw_exc(_internal::getALErrorString(alcGetError(_device)));
     }
-    _context = alcCreateContext(_device, nullptr);
-    if (_context == nullptr) {
+    _set_thread_context = nullptr;
+    if (alcIsExtensionPresent(_device, "ALC_EXT_thread_local_context") == ALC_TRUE) {
+        _set_thread_context = reinterpret_cast<PFNALCSETTHREADCONTEXTPROC>(
+            alcGetProcAddress(_device, "alcSetThreadContext"));
+    }
+}
+
+
+void Device::_createContext()
+{
+    _contexts[0] = _newContext();
+    if (!alcMakeContextCurrent(_contexts[0])) {
         SSS::throw_exc(_internal::getALErrorString(alcGetError(_device)));
     }
-    if (!alcMakeContextCurrent(_context)) {
+    // Loaded on their own, as they batch more than EFX changes
+    _defer_updates = nullptr;
+    _process_updates = nullptr;
+    if (alIsExtensionPresent("AL_SOFT_deferred_updates")) {
+        _defer_updates = reinterpret_cast<LPALDEFERUPDATESSOFT>(alGetProcAddress("alDeferUpdatesSOFT"));
+        _process_updates = reinterpret_cast<LPALPROCESSUPDATESSOFT>(alGetProcAddress("alProcessUpdatesSOFT"));
+    }
+    _efx = loadEFX(_device);
+}
+
+
+ALCcontext* Device::_newContext() const
+{
+    std::vector<ALCint> const attributes = _getAttributes();
+    ALCcontext* context = alcCreateContext(_device, attributes.data());
+    if (context == nullptr) {
         SSS::throw_exc(_internal::getALErrorString(alcGetError(_device)));
     }
+    return context;
+}
+
+
+void Device::_unbindContexts() noexcept
+{
+    if (_set_thread_context) {
+        _set_thread_context(nullptr);
+    }
+    _epoch.fetch_add(1, std::memory_order_acq_rel);
+}
+
+
+void Device::_open(char const* specifier)
+{
+    _openDevice(specifier);
+    _createContext();
+}
+
+
+void Device::_close() noexcept
+{
+    _unbindContexts();
+    alcMakeContextCurrent(nullptr);
+    _efx.reset();
+    for (ALCcontext*& context : _contexts) {
+        if (context != nullptr) {
+            alcDestroyContext(context);
+            context = nullptr;
+        }
+    }
+    if (_device != nullptr) {
+        alcCloseDevice(_device);
+        _device = nullptr;
+    }
+}
+
+
+void Device::_switch(char const* specifier)
+{
+    std::lock_guard const lock(getMutex());
+    Clock::time_point const start = Clock::now();
+
+    // Reopen in place, every OpenAL object stays valid
+    if (!_lost && alcIsExtensionPresent(_device, "ALC_SOFT_reopen_device") == ALC_TRUE) {
+        auto const reopen = reinterpret_cast<LPALCREOPENDEVICESOFT>(
+            alcGetProcAddress(_device, "alcReopenDeviceSOFT"));
+        std::vector<ALCint> const attributes = _getAttributes();
+        if (reopen && reopen(_device, specifier, attributes.data()) == ALC_TRUE) {
+            _current_device = _getOpenedDevice();
+            _last_switch_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            LOG_MSG("OpenAL device reopened");
+            return;
+        }
+        LOG_CTX_WRN("SSS/Audio", "Couldn't reopen device in place, rebuilding it.");
+    }
+
+    // Snapshot listeners, Sources & effects, then free every OpenAL object.
+    // Already done if the previous switch lost the device.
+    if (!_lost) {
+        for (uint32_t i = 0; i < max_contexts; ++i) {
+            if (_contexts[i]) {
+                bindContext(i);
+                _listeners[i] = _getListener();
+            }
+        }
+        Source::_suspendAll();
+        EffectSlot::_suspendAll();
+        Buffer::_suspendAll();
+        _close();
+    }
+
+    // Open new device, falling back on the default one
+    try {
+        _open(specifier);
+    }
+    catch (std::exception const& e) {
+        // Retries only log once
+        if (!_lost) {
+            LOG_FUNC_ERR(e.what());
+        }
+        _close();
+        try {
+            _open(nullptr);
+        }
+        catch (std::exception const& fallback_error) {
+            // Retried by checkConnection()
+            if (!_lost) {
+                LOG_FUNC_ERR(fallback_error.what());
+            }
+            _close();
+            _lost = true;
+            _retry_time = Clock::now() + _retry_period;
+            _current_device.clear();
+            return;
+        }
+    }
+    _lost = false;
+    _current_device = _getOpenedDevice();
+
+    // Rebuild everything on the new contexts
+    for (uint32_t i = 1; i < max_contexts; ++i) {
+        if (_listeners[i]) {
+            _contexts[i] = _newContext();
+            if (!_set_thread_context) {
+                LOG_CTX_WRN("SSS/Audio", CONTEXT_MSG("New device lacks ALC_EXT_thread_local_context,"
+                    " context bound process-wide", i));
+            }
+        }
+    }
+    for (uint32_t i = 0; i < max_contexts; ++i) {
+        if (_listeners[i]) {
+            bindContext(i);
+            _setListener(*_listeners[i]);
+            _listeners[i].reset();
+        }
+    }
+    Buffer::_resumeAll();
+    EffectSlot::_resumeAll();
+    Source::_resumeAll();
+    _last_switch_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    LOG_MSG("OpenAL device & context rebuilt");
+}
+
+
+std::string Device::_getOpenedDevice() const
+{
+    // Querying the opened device doesn't enumerate the others
+    ALCenum const param = alcIsExtensionPresent(_device, "ALC_ENUMERATE_ALL_EXT") == ALC_TRUE
+        ? ALC_ALL_DEVICES_SPECIFIER : ALC_DEVICE_SPECIFIER;
+    ALCchar const* name = alcGetString(_device, param);
+    return name ? _getDeviceKey(name) : std::string();
+}
+
+
+void Device::_collectDevices()
+{
+    if (!_enumeration.valid())
+        return;
+    try {
+        auto [devices, duration_ms] = _enumeration.get();
+        _all_devices = std::move(devices);
+        _init_stats.enumerate_ms = duration_ms;
+        _init_stats.enumerated = true;
+    }
+    catch (std::exception const& e) {
+        LOG_FUNC_ERR(e.what());
+    }
+}
+
+
+void Device::checkConnection()
+{
+    // Sources stay suspended until a device opens again
+    if (_lost) {
+        if (Clock::now() >= _retry_time) {
+            _switch(nullptr);
+        }
+        return;
+    }
+    if (_device == nullptr || alcIsExtensionPresent(_device, "ALC_EXT_disconnect") != ALC_TRUE)
+        return;
+    ALCint connected = ALC_TRUE;
+    alcGetIntegerv(_device, ALC_CONNECTED, 1, &connected);
+    if (connected == ALC_FALSE) {
+        LOG_CTX_WRN("SSS/Audio", CONTEXT_MSG("Device disconnected, failing over to default", _current_device));
+        _switch(nullptr);
+    }
 }
 
 
 Device::Device() try
 {
-    updateDevices();
-    _init();
+    Clock::time_point const start = Clock::now();
+    auto const elapsed_ms = [](Clock::time_point& from) {
+        Clock::time_point const now = Clock::now();
+        double const ms = std::chrono::duration<double, std::milli>(now - from).count();
+        from = now;
+        return ms;
+    };
+    Clock::time_point phase = start;
+
+    // Default device, without waiting for the enumeration
+    _openDevice(nullptr);
+    _init_stats.open_ms = elapsed_ms(phase);
+    _createContext();
+    _alive = this;
+    _current_device = _getOpenedDevice();
+    _init_stats.context_ms = elapsed_ms(phase);
+    // Buffers loaded before the device existed
+    Buffer::_uploadAll();
+    _init_stats.upload_ms = elapsed_ms(phase);
+
+    _enumeration = std::async(std::launch::async, []() {
+        Clock::time_point const enumeration_start = Clock::now();
+        auto devices = _enumerateDevices();
+        return std::make_pair(std::move(devices), std::chrono::duration<double, std::milli>(
+            Clock::now() - enumeration_start).count());
+    });
+    _init_stats.total_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
     LOG_MSG("OpenAL device & context created");
 }
 CATCH_AND_RETHROW_METHOD_EXC;
@@ -83,12 +440,13 @@ Device::~Device()
 {
     // Free resources
     Source::clearAll();
+    Capture::clearAll();
+    Analyzer::clearAll();
     Buffer::clearAll();
-    // Unbind context
-    alcMakeContextCurrent(NULL);
-    // Free context & device
-    alcDestroyContext(_context);
-    alcCloseDevice(_device);
+    EffectSlot::clearAll();
+    // Unbind contexts, free contexts & device
+    _close();
+    _alive = nullptr;
     LOG_MSG("OpenAL device & context destroyed");
 }
 
@@ -99,48 +457,162 @@ Device& Device::get()
 }
 
 
-void Device::updateDevices()
+std::unordered_map<std::string, std::string> Device::getAllDevices()
 {
-    _all_devices.clear();
-    if (alcIsExtensionPresent(NULL, "ALC_ENUMERATE_ALL_EXT") == ALC_TRUE) {
-        // Retrieve devices
-        ALchar const* devices = alcGetString(NULL, ALC_ALL_DEVICES_SPECIFIER);
-        ALCchar const* device = devices, * next = devices + 1;
-        // Add each device one by one
-        while (device && *device != '\0' && next && *next != '\0') {
-            std::string const needle("OpenAL Soft on ");
-            std::string key = device;
-            size_t const len = key.size();
-            size_t const id = key.find(needle);
-            if (id + needle.size() < key.size()) {
-                key = key.substr(id + needle.size());
-            }
-            _all_devices[key] = device;
-            device += (len + 1);
-            next += (len + 2);
+    std::lock_guard const lock(_devices_mutex);
+    _collectDevices();
+    return _all_devices;
+}
+
+
+void Device::selectDevice(std::string const& name)
+{
+    if (name == _current_device)
+        return;
+    if (_render_samples) {
+        LOG_METHOD_CTX_WRN("Loopback devices can't switch to another device", name);
+        return;
+    }
+    auto const devices = getAllDevices();
+    auto const it = devices.find(name);
+    if (it == devices.cend()) {
+        LOG_METHOD_CTX_WRN("Couldn't find a device with given name", name);
+        return;
+    }
+    _switch(it->second.c_str());
+}
+
+
+std::vector<ALCint> Device::_getAttributes() const
+{
+    std::vector<ALCint> attributes;
+    auto const add = [&](ALCint key, ALCint value) {
+        if (value > 0) {
+            attributes.push_back(key);
+            attributes.push_back(value);
+        }
+    };
+    if (_settings.loopback) {
+        // Loopback devices have no default format
+        attributes.insert(attributes.end(), {
+            ALC_FORMAT_CHANNELS_SOFT, ALC_STEREO_SOFT,
+            ALC_FORMAT_TYPE_SOFT, ALC_SHORT_SOFT,
+            ALC_FREQUENCY, _settings.frequency > 0 ? _settings.frequency : 48000,
+        });
+    }
+    else {
+        add(ALC_FREQUENCY, _settings.frequency);
+    }
+    if (_settings.period_size > 0) {
+        // OpenAL has no period attribute, the refresh rate sets it
+        ALCint frequency = _settings.frequency;
+        if (frequency <= 0 && _device) {
+            alcGetIntegerv(_device, ALC_FREQUENCY, 1, &frequency);
+        }
+        if (frequency <= 0) {
+            frequency = 48000;
         }
+        add(ALC_REFRESH, std::max(frequency / _settings.period_size, 1));
     }
+    else {
+        add(ALC_REFRESH, _settings.refresh);
+    }
+    add(ALC_MONO_SOURCES, _settings.mono_sources);
+    add(ALC_STEREO_SOURCES, _settings.stereo_sources);
+    add(ALC_MAX_AUXILIARY_SENDS, _settings.max_sends);
+    if (_settings.output_mode != DeviceSettings::OutputMode::Any && !_settings.loopback && _device
+        && alcIsExtensionPresent(_device, "ALC_SOFT_output_mode") == ALC_TRUE)
+    {
+        static constexpr ALCint modes[] = {
+            ALC_ANY_SOFT,
+            ALC_MONO_SOFT,
+            ALC_STEREO_SOFT,
+            ALC_STEREO_BASIC_SOFT,
+            ALC_STEREO_UHJ_SOFT,
+            ALC_STEREO_HRTF_SOFT,
+            ALC_QUAD_SOFT,
+            ALC_SURROUND_5_1_SOFT,
+            ALC_SURROUND_6_1_SOFT,
+            ALC_SURROUND_7_1_SOFT,
+        };
+        attributes.push_back(ALC_OUTPUT_MODE_SOFT);
+        attributes.push_back(modes[static_cast<size_t>(_settings.output_mode)]);
+    }
+    attributes.push_back(0);
+    return attributes;
 }
 
 
-void Device::selectDevice(std::string const& name)
+void Device::configure(DeviceSettings const& settings)
+{
+    // Device switches & retries happen on the audio thread
+    std::lock_guard const lock(getMutex());
+    _settings = settings;
+    if (!_ptr)
+        return;
+    if (settings.loopback != (_ptr->_render_samples != nullptr)) {
+        LOG_CTX_WRN("SSS/Audio", "Loopback mode can only be set before init().");
+        _settings.loopback = !settings.loopback;
+    }
+    // Lost devices are reopened with the new settings
+    if (_ptr->_lost || !_ptr->_device) {
+        LOG_CTX_WRN("SSS/Audio", "No device is open, settings apply to the next device.");
+        return;
+    }
+    ALCdevice* device = _ptr->_device;
+    if (alcIsExtensionPresent(device, "ALC_SOFT_HRTF") != ALC_TRUE) {
+        LOG_CTX_WRN("SSS/Audio", "alcResetDeviceSOFT unavailable, settings apply to the next device.");
+        return;
+    }
+    // Resets the device in place, Sources & Buffers are kept
+    auto const reset = reinterpret_cast<LPALCRESETDEVICESOFT>(alcGetProcAddress(device, "alcResetDeviceSOFT"));
+    std::vector<ALCint> const attributes = _ptr->_getAttributes();
+    if (!reset || reset(device, attributes.data()) != ALC_TRUE) {
+        SSS::throw_exc("Couldn't reset device: " + getALErrorString(alcGetError(device)));
+    }
+    LOG_MSG("OpenAL device reconfigured");
+}
+
+
+DeviceInfo Device::getInfo() const
 {
-    bool found = false;
-    for (auto const& pair : _all_devices) {
-        if (name == pair.first) {
-            _init(pair.first);
-            found = true;
-            break;
+    DeviceInfo info;
+    alcGetIntegerv(_device, ALC_FREQUENCY, 1, &info.frequency);
+    alcGetIntegerv(_device, ALC_REFRESH, 1, &info.refresh);
+    alcGetIntegerv(_device, ALC_MONO_SOURCES, 1, &info.mono_sources);
+    alcGetIntegerv(_device, ALC_STEREO_SOURCES, 1, &info.stereo_sources);
+    alcGetIntegerv(_device, ALC_MAX_AUXILIARY_SENDS, 1, &info.max_sends);
+    if (alcIsExtensionPresent(_device, "ALC_SOFT_device_clock") == ALC_TRUE) {
+        auto const get = reinterpret_cast<LPALCGETINTEGER64VSOFT>(
+            alcGetProcAddress(_device, "alcGetInteger64vSOFT"));
+        ALCint64SOFT latency_ns = 0;
+        if (get) {
+            get(_device, ALC_DEVICE_LATENCY_SOFT, 1, &latency_ns);
+            info.latency_ms = static_cast<double>(latency_ns) / 1e6;
         }
     }
-    if (!found) {
-        LOG_METHOD_CTX_WRN("Couldn't find a device with given name", name);
+    info.switch_ms = _last_switch_ms;
+    info.loopback = _render_samples != nullptr;
+    return info;
+}
+
+
+InitStats Device::getInitStats()
+{
+    std::lock_guard const lock(_devices_mutex);
+    if (_enumeration.valid()
+        && _enumeration.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        _collectDevices();
     }
+    return _init_stats;
 }
 
 
 void Device::setMainVolume(int volume) noexcept try
 {
+    std::lock_guard const lock(getMutex());
+    bindContext(0);
     alListenerf(AL_GAIN, static_cast<float>(volume) / 100.f);
 }
 CATCH_AND_LOG_FUNC_EXC;
@@ -149,6 +621,8 @@ CATCH_AND_LOG_FUNC_EXC;
 int Device::getMainVolume() const noexcept
 {
     try {
+        std::lock_guard const lock(getMutex());
+        bindContext(0);
         ALfloat gain;
         alGetListenerf(AL_GAIN, &gain);
         return static_cast<int>(gain * 100.f);
@@ -159,11 +633,155 @@ int Device::getMainVolume() const noexcept
     }
 }
 
+uint32_t Device::createContext()
+{
+    std::lock_guard const lock(getMutex());
+    // Without per-thread binding, contexts would share one process-wide current
+    if (!_set_thread_context) {
+        SSS::throw_exc("ALC_EXT_thread_local_context isn't supported, only the main context is available.");
+    }
+    for (uint32_t i = 1; i < max_contexts; ++i) {
+        if (_contexts[i] == nullptr) {
+            _contexts[i] = _newContext();
+            return i;
+        }
+    }
+    SSS::throw_exc(CONTEXT_MSG("Can't create more contexts", max_contexts));
+    return 0;
+}
+
+
+void Device::removeContext(uint32_t context_id)
+{
+    std::lock_guard const lock(getMutex());
+    if (context_id == 0) {
+        LOG_METHOD_CTX_WRN("The main context can't be removed", context_id);
+        return;
+    }
+    if (!hasContext(context_id)) {
+        LOG_METHOD_CTX_WRN("Couldn't find a context with given ID", context_id);
+        return;
+    }
+    for (auto const& source : Source::getArray()) {
+        if (source && source->getContext() == context_id) {
+            Source::remove(source->getID());
+        }
+    }
+    _unbindContexts();
+    alcDestroyContext(_contexts[context_id]);
+    _contexts[context_id] = nullptr;
+}
+
+
+bool Device::renderMix(short* samples, size_t frames)
+{
+    if (!_render_samples)
+        return false;
+    std::lock_guard const lock(getMutex());
+    _render_samples(_device, samples, static_cast<ALCsizei>(frames));
+    Analyzer* analyzer = _mix_analyzer ? Analyzer::get(*_mix_analyzer) : nullptr;
+    if (analyzer) {
+        ALCint frequency = 0;
+        alcGetIntegerv(_device, ALC_FREQUENCY, 1, &frequency);
+        analyzer->feed(samples, frames, 2, frequency);
+    }
+    return true;
+}
+
+
+std::vector<uint32_t> Device::getContexts() const
+{
+    std::vector<uint32_t> ids;
+    for (uint32_t i = 0; i < max_contexts; ++i) {
+        if (_contexts[i] != nullptr) {
+            ids.push_back(i);
+        }
+    }
+    return ids;
+}
+
+
+void bindContext(uint32_t context_id) noexcept
+{
+    thread_local uint32_t bound_id = 0;
+    thread_local uint64_t bound_epoch = 0;
+    // Bindings stay valid until a context is destroyed, which bumps the epoch
+    if (bound_id == context_id && bound_epoch == Device::_epoch.load(std::memory_order_acquire))
+        return;
+    // Contexts are only created & destroyed under the engine mutex
+    std::lock_guard const lock(getMutex());
+    Device const* device = Device::_alive;
+    if (!device || context_id >= max_contexts)
+        return;
+    ALCcontext* context = device->_contexts[context_id];
+    if (context == nullptr)
+        return;
+    if (!device->_set_thread_context) {
+        // Process-wide fallback, shared by every thread
+        if (alcGetCurrentContext() != context) {
+            alcMakeContextCurrent(context);
+        }
+        return;
+    }
+    device->_set_thread_context(context);
+    bound_id = context_id;
+    bound_epoch = Device::_epoch.load(std::memory_order_acquire);
+}
+
+
+bool hasContext(uint32_t context_id) noexcept
+{
+    std::lock_guard const lock(getMutex());
+    Device const* device = Device::_alive;
+    return device && context_id < max_contexts && device->_contexts[context_id] != nullptr;
+}
+
+
+EFXFunctions const* getEFX() noexcept
+{
+    Device const* device = Device::_alive;
+    return device && device->_efx ? &*device->_efx : nullptr;
+}
+
+
+DeferredUpdates::~DeferredUpdates()
+{
+    Device const* device = Device::_alive;
+    if (!device || !device->_process_updates)
+        return;
+    for (uint32_t i = 0; i < _deferred.size(); ++i) {
+        if (_deferred[i]) {
+            bindContext(i);
+            device->_process_updates();
+        }
+    }
+}
+
+
+void DeferredUpdates::add(uint32_t context_id) noexcept
+{
+    Device const* device = Device::_alive;
+    if (!device || !device->_defer_updates || context_id >= _deferred.size() || _deferred[context_id])
+        return;
+    device->_defer_updates();
+    _deferred[context_id] = true;
+}
+
+
 bool is_init() noexcept
 {
     return !!Device::_ptr;
 }
 
+
+void checkDevice() try
+{
+    if (Device::_ptr) {
+        Device::_ptr->checkConnection();
+    }
+}
+CATCH_AND_LOG_FUNC_EXC;
+
 INTERNAL_END;
 
 void init()
@@ -174,6 +792,7 @@ void init()
 
 void terminate()
 {
+    stopThread();
     _internal::Device::_ptr.reset();
 }
 
@@ -211,21 +830,159 @@ std::string getCurrentDevice() noexcept
 
 void selectDevice(std::string const& name) noexcept try
 {
+    _internal::TraceCall const trace(TraceOp::SelectDevice, name);
     _internal::Device::get().selectDevice(name);
 }
 CATCH_AND_LOG_FUNC_EXC;
 
 
+void configureDevice(DeviceSettings const& settings) noexcept try
+{
+    _internal::TraceCall const trace(TraceOp::ConfigureDevice, settings.frequency, settings.period_size,
+        settings.refresh, settings.mono_sources, settings.stereo_sources, settings.max_sends,
+        static_cast<int32_t>(settings.output_mode));
+    _internal::Device::configure(settings);
+}
+CATCH_AND_LOG_FUNC_EXC;
+
+
+DeviceSettings getDeviceSettings() noexcept
+{
+    return _internal::Device::getSettings();
+}
+
+
+DeviceInfo getDeviceInfo() noexcept
+{
+    try {
+        return _internal::Device::get().getInfo();
+    }
+    catch (std::exception const& e) {
+        LOG_FUNC_ERR(e.what());
+        return DeviceInfo();
+    }
+}
+
+
+bool renderMix(short* samples, size_t frames) noexcept
+{
+    try {
+        return _internal::Device::get().renderMix(samples, frames);
+    }
+    catch (std::exception const& e) {
+        LOG_FUNC_ERR(e.what());
+        return false;
+    }
+}
+
+
+void setMixAnalyzer(std::optional<uint32_t> analyzer_id) noexcept try
+{
+    _internal::Device::get().setMixAnalyzer(analyzer_id);
+}
+CATCH_AND_LOG_FUNC_EXC;
+
+
 void setMainVolume(int volume) noexcept try
 {
+    _internal::TraceCall const trace(TraceOp::SetMainVolume, volume);
     _internal::Device::get().setMainVolume(volume);
 }
 CATCH_AND_LOG_FUNC_EXC;
 
 
+InitStats getInitStats() noexcept
+{
+    try {
+        // Doesn't open the device
+        if (!_internal::Device::_ptr)
+            return InitStats();
+        return _internal::Device::_ptr->getInitStats();
+    }
+    catch (std::exception const& e) {
+        LOG_FUNC_ERR(e.what());
+        return InitStats();
+    }
+}
+
+
 int getMainVolume() noexcept
 {
     return _internal::Device::get().getMainVolume();
 }
 
+
+uint32_t createContext()
+{
+    uint32_t const context_id = _internal::Device::get().createContext();
+    // Recorded once created, replays check they get the same id
+    _internal::TraceCall const trace(TraceOp::ContextCreate, context_id);
+    return context_id;
+}
+
+
+void removeContext(uint32_t context_id) noexcept try
+{
+    _internal::TraceCall const trace(TraceOp::ContextRemove, context_id);
+    _internal::Device::get().removeContext(context_id);
+}
+CATCH_AND_LOG_FUNC_EXC;
+
+
+std::vector<uint32_t> getContexts() noexcept
+{
+    try {
+        return _internal::Device::get().getContexts();
+    }
+    catch (std::exception const& e) {
+        LOG_FUNC_ERR(e.what());
+        return {};
+    }
+}
+
+
+void setListenerGain(uint32_t context_id, float gain) noexcept try
+{
+    _internal::TraceCall const trace(TraceOp::SetListenerGain, context_id, gain);
+    std::lock_guard const lock(_internal::getMutex());
+    if (!_internal::hasContext(context_id)) {
+        LOG_FUNC_CTX_WRN("Couldn't find a context with given ID", context_id);
+        return;
+    }
+    _internal::bindContext(context_id);
+    alListenerf(AL_GAIN, gain);
+}
+CATCH_AND_LOG_FUNC_EXC;
+
+
+void setListenerPosition(uint32_t context_id, float x, float y, float z) noexcept try
+{
+    _internal::TraceCall const trace(TraceOp::SetListenerPosition, context_id, x, y, z);
+    std::lock_guard const lock(_internal::getMutex());
+    if (!_internal::hasContext(context_id)) {
+        LOG_FUNC_CTX_WRN("Couldn't find a context with given ID", context_id);
+        return;
+    }
+    _internal::bindContext(context_id);
+    alListener3f(AL_POSITION, x, y, z);
+}
+CATCH_AND_LOG_FUNC_EXC;
+
+
+void setListenerOrientation(uint32_t context_id,
+    std::array<float, 3> const& at, std::array<float, 3> const& up) noexcept try
+{
+    _internal::TraceCall const trace(TraceOp::SetListenerOrientation, context_id,
+        at[0], at[1], at[2], up[0], up[1], up[2]);
+    std::lock_guard const lock(_internal::getMutex());
+    if (!_internal::hasContext(context_id)) {
+        LOG_FUNC_CTX_WRN("Couldn't find a context with given ID", context_id);
+        return;
+    }
+    _internal::bindContext(context_id);
+    std::array<ALfloat, 6> const orientation{ at[0], at[1], at[2], up[0], up[1], up[2] };
+    alListenerfv(AL_ORIENTATION, orientation.data());
+}
+CATCH_AND_LOG_FUNC_EXC;
+
 SSS_AUDIO_END;
\ No newline at end of file
@@ -0,0 +1,498 @@
+#include "Audio/Effect.hpp"
+#include "Audio/Source.hpp"
+#include "Audio/Bus.hpp"
+#include "Audio/Trace.hpp"
+
+#include <AL/efx-presets.h>
+#include <cmath>
+#include <cstring>
+
+SSS_AUDIO_BEGIN;
+INTERNAL_BEGIN;
+
+template<typename T>
+static void _load(T& ptr, char const* name)
+{
+    ptr = reinterpret_cast<T>(alGetProcAddress(name));
+    if (ptr == nullptr) {
+        SSS::throw_exc(CONTEXT_MSG("Couldn't load EFX function", name));
+    }
+}
+
+
+std::optional<EFXFunctions> loadEFX(ALCdevice* device) noexcept
+{
+    if (alcIsExtensionPresent(device, "ALC_EXT_EFX") != ALC_TRUE) {
+        LOG_CTX_WRN("SSS/Audio", "EFX isn't supported by the current device.");
+        return std::nullopt;
+    }
+    try {
+        EFXFunctions efx{};
+        _load(efx.GenEffects, "alGenEffects");
+        _load(efx.DeleteEffects, "alDeleteEffects");
+        _load(efx.Effecti, "alEffecti");
+        _load(efx.Effectf, "alEffectf");
+        _load(efx.Effectfv, "alEffectfv");
+        _load(efx.GenFilters, "alGenFilters");
+        _load(efx.DeleteFilters, "alDeleteFilters");
+        _load(efx.Filteri, "alFilteri");
+        _load(efx.Filterf, "alFilterf");
+        _load(efx.GenAuxiliaryEffectSlots, "alGenAuxiliaryEffectSlots");
+        _load(efx.DeleteAuxiliaryEffectSlots, "alDeleteAuxiliaryEffectSlots");
+        _load(efx.AuxiliaryEffectSloti, "alAuxiliaryEffectSloti");
+        _load(efx.AuxiliaryEffectSlotf, "alAuxiliaryEffectSlotf");
+        efx.eax_reverb = alGetEnumValue("AL_EFFECT_EAXREVERB") != 0;
+        return efx;
+    }
+    catch (std::exception const& e) {
+        LOG_FUNC_ERR(e.what());
+        return std::nullopt;
+    }
+}
+
+
+ALuint makeFilter(ALuint& id, Filter const& filter)
+{
+    EFXFunctions const* efx = getEFX();
+    if (!efx || filter.type == Filter::Type::None)
+        return AL_FILTER_NULL;
+    if (id == 0) {
+        efx->GenFilters(1, &id);
+        if (id == 0) {
+            SSS::throw_exc("Couldn't generate an OpenAL filter: " + getALErrorString(alGetError()));
+        }
+    }
+    switch (filter.type) {
+    case Filter::Type::LowPass:
+        efx->Filteri(id, AL_FILTER_TYPE, AL_FILTER_LOWPASS);
+        efx->Filterf(id, AL_LOWPASS_GAIN, filter.gain);
+        efx->Filterf(id, AL_LOWPASS_GAINHF, filter.gain_hf);
+        break;
+    case Filter::Type::HighPass:
+        efx->Filteri(id, AL_FILTER_TYPE, AL_FILTER_HIGHPASS);
+        efx->Filterf(id, AL_HIGHPASS_GAIN, filter.gain);
+        efx->Filterf(id, AL_HIGHPASS_GAINLF, filter.gain_lf);
+        break;
+    case Filter::Type::BandPass:
+        efx->Filteri(id, AL_FILTER_TYPE, AL_FILTER_BANDPASS);
+        efx->Filterf(id, AL_BANDPASS_GAIN, filter.gain);
+        efx->Filterf(id, AL_BANDPASS_GAINLF, filter.gain_lf);
+        efx->Filterf(id, AL_BANDPASS_GAINHF, filter.gain_hf);
+        break;
+    default:
+        break;
+    }
+    return id;
+}
+
+
+void deleteFilter(ALuint& id) noexcept
+{
+    EFXFunctions const* efx = getEFX();
+    if (efx && id != 0) {
+        efx->DeleteFilters(1, &id);
+    }
+    id = 0;
+}
+
+
+void updateEffects()
+{
+    std::lock_guard const lock(getMutex());
+    EFXFunctions const* efx = getEFX();
+    if (!efx)
+        return;
+    // Slots only live in the main context
+    bindContext(0);
+    // Apply all parameter changes at once
+    DeferredUpdates batch;
+    for (auto const& pair : EffectSlot::getMap()) {
+        EffectSlot& slot = *pair.second;
+        slot._blendZones();
+        if (!slot._dirty)
+            continue;
+        batch.add(0);
+        slot._flush();
+    }
+}
+
+INTERNAL_END;
+
+
+static EFXEAXREVERBPROPERTIES const _presets[] = {
+    EFX_REVERB_PRESET_GENERIC,
+    EFX_REVERB_PRESET_ROOM,
+    EFX_REVERB_PRESET_BATHROOM,
+    EFX_REVERB_PRESET_LIVINGROOM,
+    EFX_REVERB_PRESET_STONEROOM,
+    EFX_REVERB_PRESET_AUDITORIUM,
+    EFX_REVERB_PRESET_CONCERTHALL,
+    EFX_REVERB_PRESET_CAVE,
+    EFX_REVERB_PRESET_ARENA,
+    EFX_REVERB_PRESET_HANGAR,
+    EFX_REVERB_PRESET_HALLWAY,
+    EFX_REVERB_PRESET_ALLEY,
+    EFX_REVERB_PRESET_FOREST,
+    EFX_REVERB_PRESET_CITY,
+    EFX_REVERB_PRESET_MOUNTAINS,
+    EFX_REVERB_PRESET_UNDERWATER,
+};
+
+static EFXEAXREVERBPROPERTIES const& _getPreset(ReverbPreset preset)
+{
+    size_t const i = static_cast<size_t>(preset);
+    return _presets[i < std::size(_presets) ? i : 0];
+}
+
+
+std::map<uint32_t, std::unique_ptr<EffectSlot>> EffectSlot::_instances{};
+
+
+EffectSlot::EffectSlot(uint32_t id)
+    : _map_id(id)
+{
+    init();
+    _internal::EFXFunctions const* efx = _internal::getEFX();
+    if (!efx) {
+        SSS::throw_exc("EFX isn't supported by the current device.");
+    }
+    _internal::bindContext(0);
+    efx->GenAuxiliaryEffectSlots(1, &_openal_slot);
+    efx->GenEffects(1, &_openal_effect);
+    if (_openal_slot == 0 || _openal_effect == 0) {
+        SSS::throw_exc("Couldn't generate an OpenAL effect slot: "
+            + _internal::getALErrorString(alGetError()));
+    }
+}
+
+
+EffectSlot::~EffectSlot()
+{
+    // Buses routing to this slot fall back to their parents' slot
+    bool routed = false;
+    for (auto const& pair : Bus::getMap()) {
+        if (pair.second && pair.second->_effect_slot == _map_id) {
+            pair.second->_effect_slot.reset();
+            routed = true;
+        }
+    }
+    // Slots can't be deleted while Sources still send to them
+    for (auto const& source : Source::getArray()) {
+        if (!source)
+            continue;
+        for (size_t i = 0; i < source->_sends.size(); ++i) {
+            if (source->_sends[i] == _map_id) {
+                source->clearSend(static_cast<ALint>(i));
+            }
+        }
+        if (routed && !source->_bus.empty()) {
+            source->_applyBusEffectSlot();
+        }
+    }
+    _internal::EFXFunctions const* efx = _internal::getEFX();
+    if (efx) {
+        _internal::bindContext(0);
+        if (_openal_slot != 0)
+            efx->DeleteAuxiliaryEffectSlots(1, &_openal_slot);
+        if (_openal_effect != 0)
+            efx->DeleteEffects(1, &_openal_effect);
+    }
+}
+
+
+EffectSlot& EffectSlot::create(uint32_t id) try
+{
+    _internal::TraceCall const trace(TraceOp::EffectSlotCreate, id);
+    std::lock_guard const lock(_internal::getMutex());
+    _instances[id].reset(new EffectSlot(id));
+    return *_instances.at(id);
+}
+CATCH_AND_RETHROW_FUNC_EXC;
+
+
+EffectSlot& EffectSlot::create()
+{
+    std::lock_guard const lock(_internal::getMutex());
+    uint32_t id = 0;
+    // Increment ID until no similar value is found
+    while (_instances.count(id) != 0) {
+        ++id;
+    }
+    return create(id);
+}
+
+
+EffectSlot* EffectSlot::get(uint32_t id) noexcept
+{
+    auto const it = _instances.find(id);
+    if (it == _instances.cend())
+        return nullptr;
+    return it->second.get();
+}
+
+
+void EffectSlot::remove(uint32_t id)
+{
+    _internal::TraceCall const trace(TraceOp::EffectSlotRemove, id);
+    std::lock_guard const lock(_internal::getMutex());
+    _instances.erase(id);
+}
+
+
+void EffectSlot::clearAll() noexcept
+{
+    std::lock_guard const lock(_internal::getMutex());
+    _instances.clear();
+}
+
+
+void EffectSlot::setReverb(ReverbPreset preset)
+{
+    _internal::TraceCall const trace(TraceOp::EffectSlotSetReverb, _map_id, static_cast<int32_t>(preset));
+    setReverb(_getPreset(preset));
+}
+
+
+void EffectSlot::setReverb(EFXEAXREVERBPROPERTIES const& properties)
+{
+    std::lock_guard const lock(_internal::getMutex());
+    _reverb = properties;
+    _has_reverb = true;
+    _markDirty();
+}
+
+
+void EffectSlot::clearEffect()
+{
+    _internal::TraceCall const trace(TraceOp::EffectSlotClearEffect, _map_id);
+    std::lock_guard const lock(_internal::getMutex());
+    _has_reverb = false;
+    _zones.clear();
+    _zone_weight = 1.f;
+    _markDirty();
+}
+
+
+void EffectSlot::setGain(float gain)
+{
+    _internal::TraceCall const trace(TraceOp::EffectSlotSetGain, _map_id, gain);
+    std::lock_guard const lock(_internal::getMutex());
+    _gain = gain;
+    _markDirty();
+}
+
+
+uint32_t EffectSlot::addZone(ReverbZone const& zone)
+{
+    _internal::TraceCall const trace(TraceOp::EffectSlotAddZone, _map_id,
+        zone.position[0], zone.position[1], zone.position[2], zone.radius, zone.blend,
+        static_cast<int32_t>(zone.preset));
+    std::lock_guard const lock(_internal::getMutex());
+    uint32_t id = 0;
+    while (_zones.count(id) != 0) {
+        ++id;
+    }
+    _zones[id] = zone;
+    _has_reverb = true;
+    _markDirty();
+    return id;
+}
+
+
+void EffectSlot::removeZone(uint32_t zone_id)
+{
+    _internal::TraceCall const trace(TraceOp::EffectSlotRemoveZone, _map_id, zone_id);
+    std::lock_guard const lock(_internal::getMutex());
+    _zones.erase(zone_id);
+    _markDirty();
+}
+
+
+void EffectSlot::clearZones()
+{
+    _internal::TraceCall const trace(TraceOp::EffectSlotClearZones, _map_id);
+    std::lock_guard const lock(_internal::getMutex());
+    _zones.clear();
+    _zone_weight = 1.f;
+    _markDirty();
+}
+
+
+
+// Calls f(dst value, src value) on each float value of the reverb properties
+template<typename F>
+static void _forEachReverbValue(EFXEAXREVERBPROPERTIES& dst, EFXEAXREVERBPROPERTIES const& src, F f)
+{
+    f(dst.flDensity, src.flDensity);
+    f(dst.flDiffusion, src.flDiffusion);
+    f(dst.flGain, src.flGain);
+    f(dst.flGainHF, src.flGainHF);
+    f(dst.flGainLF, src.flGainLF);
+    f(dst.flDecayTime, src.flDecayTime);
+    f(dst.flDecayHFRatio, src.flDecayHFRatio);
+    f(dst.flDecayLFRatio, src.flDecayLFRatio);
+    f(dst.flReflectionsGain, src.flReflectionsGain);
+    f(dst.flReflectionsDelay, src.flReflectionsDelay);
+    f(dst.flLateReverbGain, src.flLateReverbGain);
+    f(dst.flLateReverbDelay, src.flLateReverbDelay);
+    f(dst.flEchoTime, src.flEchoTime);
+    f(dst.flEchoDepth, src.flEchoDepth);
+    f(dst.flModulationTime, src.flModulationTime);
+    f(dst.flModulationDepth, src.flModulationDepth);
+    f(dst.flAirAbsorptionGainHF, src.flAirAbsorptionGainHF);
+    f(dst.flHFReference, src.flHFReference);
+    f(dst.flLFReference, src.flLFReference);
+    f(dst.flRoomRolloffFactor, src.flRoomRolloffFactor);
+    for (size_t i = 0; i < 3; ++i) {
+        f(dst.flReflectionsPan[i], src.flReflectionsPan[i]);
+        f(dst.flLateReverbPan[i], src.flLateReverbPan[i]);
+    }
+}
+
+
+void EffectSlot::_blendZones()
+{
+    if (_zones.empty())
+        return;
+
+    std::array<float, 3> listener;
+    alGetListener3f(AL_POSITION, &listener[0], &listener[1], &listener[2]);
+
+    // Weighted sum of every zone's properties
+    float total = 0.f;
+    EFXEAXREVERBPROPERTIES sum{};
+    for (auto const& pair : _zones) {
+        ReverbZone const& zone = pair.second;
+        float const dx = listener[0] - zone.position[0];
+        float const dy = listener[1] - zone.position[1];
+        float const dz = listener[2] - zone.position[2];
+        float const distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+        float weight = 1.f;
+        if (distance > zone.radius) {
+            weight = zone.blend > 0.f ? 1.f - (distance - zone.radius) / zone.blend : 0.f;
+        }
+        if (weight <= 0.f)
+            continue;
+        EFXEAXREVERBPROPERTIES const& p = _getPreset(zone.preset);
+        _forEachReverbValue(sum, p, [weight](float& dst, float src) { dst += src * weight; });
+        sum.iDecayHFLimit |= p.iDecayHFLimit;
+        total += weight;
+    }
+
+    float const weight = std::min(total, 1.f);
+    if (total > 0.f) {
+        _forEachReverbValue(sum, sum, [total](float& dst, float) { dst /= total; });
+        if (std::memcmp(&sum, &_reverb, sizeof(sum)) != 0) {
+            _reverb = sum;
+            _dirty = true;
+        }
+    }
+    if (weight != _zone_weight) {
+        _zone_weight = weight;
+        _dirty = true;
+    }
+}
+
+
+void EffectSlot::_flush()
+{
+    _internal::EFXFunctions const* efx = _internal::getEFX();
+    if (!efx)
+        return;
+    _dirty = false;
+    if (!_has_reverb) {
+        efx->AuxiliaryEffectSloti(_openal_slot, AL_EFFECTSLOT_EFFECT, AL_EFFECT_NULL);
+        return;
+    }
+    EFXEAXREVERBPROPERTIES const& r = _reverb;
+    if (efx->eax_reverb) {
+        efx->Effecti(_openal_effect, AL_EFFECT_TYPE, AL_EFFECT_EAXREVERB);
+        efx->Effectf(_openal_effect, AL_EAXREVERB_DENSITY, r.flDensity);
+        efx->Effectf(_openal_effect, AL_EAXREVERB_DIFFUSION, r.flDiffusion);
+        efx->Effectf(_openal_effect, AL_EAXREVERB_GAIN, r.flGain);
+        efx->Effectf(_openal_effect, AL_EAXREVERB_GAINHF, r.flGainHF);
+        efx->Effectf(_openal_effect, AL_EAXREVERB_GAINLF, r.flGainLF);
+        efx->Effectf(_openal_effect, AL_EAXREVERB_DECAY_TIME, r.flDecayTime);
+        efx->Effectf(_openal_effect, AL_EAXREVERB_DECAY_HFRATIO, r.flDecayHFRatio);
+        efx->Effectf(_openal_effect, AL_EAXREVERB_DECAY_LFRATIO, r.flDecayLFRatio);
+        efx->Effectf(_openal_effect, AL_EAXREVERB_REFLECTIONS_GAIN, r.flReflectionsGain);
+        efx->Effectf(_openal_effect, AL_EAXREVERB_REFLECTIONS_DELAY, r.flReflectionsDelay);
+        efx->Effectfv(_openal_effect, AL_EAXREVERB_REFLECTIONS_PAN, r.flReflectionsPan);
+        efx->Effectf(_openal_effect, AL_EAXREVERB_LATE_REVERB_GAIN, r.flLateReverbGain);
+        efx->Effectf(_openal_effect, AL_EAXREVERB_LATE_REVERB_DELAY, r.flLateReverbDelay);
+        efx->Effectfv(_openal_effect, AL_EAXREVERB_LATE_REVERB_PAN, r.flLateReverbPan);
+        efx->Effectf(_openal_effect, AL_EAXREVERB_ECHO_TIME, r.flEchoTime);
+        efx->Effectf(_openal_effect, AL_EAXREVERB_ECHO_DEPTH, r.flEchoDepth);
+        efx->Effectf(_openal_effect, AL_EAXREVERB_MODULATION_TIME, r.flModulationTime);
+        efx->Effectf(_openal_effect, AL_EAXREVERB_MODULATION_DEPTH, r.flModulationDepth);
+        efx->Effectf(_openal_effect, AL_EAXREVERB_AIR_ABSORPTION_GAINHF, r.flAirAbsorptionGainHF);
+        efx->Effectf(_openal_effect, AL_EAXREVERB_HFREFERENCE, r.flHFReference);
+        efx->Effectf(_openal_effect, AL_EAXREVERB_LFREFERENCE, r.flLFReference);
+        efx->Effectf(_openal_effect, AL_EAXREVERB_ROOM_ROLLOFF_FACTOR, r.flRoomRolloffFactor);
+        efx->Effecti(_openal_effect, AL_EAXREVERB_DECAY_HFLIMIT, r.iDecayHFLimit);
+    }
+    else {
+        // Standard reverb, subset of EAX reverb
+        efx->Effecti(_openal_effect, AL_EFFECT_TYPE, AL_EFFECT_REVERB);
+        efx->Effectf(_openal_effect, AL_REVERB_DENSITY, r.flDensity);
+        efx->Effectf(_openal_effect, AL_REVERB_DIFFUSION, r.flDiffusion);
+        efx->Effectf(_openal_effect, AL_REVERB_GAIN, r.flGain);
+        efx->Effectf(_openal_effect, AL_REVERB_GAINHF, r.flGainHF);
+        efx->Effectf(_openal_effect, AL_REVERB_DECAY_TIME, r.flDecayTime);
+        efx->Effectf(_openal_effect, AL_REVERB_DECAY_HFRATIO, r.flDecayHFRatio);
+        efx->Effectf(_openal_effect, AL_REVERB_REFLECTIONS_GAIN, r.flReflectionsGain);
+        efx->Effectf(_openal_effect, AL_REVERB_REFLECTIONS_DELAY, r.flReflectionsDelay);
+        efx->Effectf(_openal_effect, AL_REVERB_LATE_REVERB_GAIN, r.flLateReverbGain);
+        efx->Effectf(_openal_effect, AL_REVERB_LATE_REVERB_DELAY, r.flLateReverbDelay);
+        efx->Effectf(_openal_effect, AL_REVERB_AIR_ABSORPTION_GAINHF, r.flAirAbsorptionGainHF);
+        efx->Effectf(_openal_effect, AL_REVERB_ROOM_ROLLOFF_FACTOR, r.flRoomRolloffFactor);
+        efx->Effecti(_openal_effect, AL_REVERB_DECAY_HFLIMIT, r.iDecayHFLimit);
+    }
+    // Effect changes only apply once (re)attached to the slot
+    efx->AuxiliaryEffectSloti(_openal_slot, AL_EFFECTSLOT_EFFECT, static_cast<ALint>(_openal_effect));
+    efx->AuxiliaryEffectSlotf(_openal_slot, AL_EFFECTSLOT_GAIN, _gain * _zone_weight);
+}
+
+
+void EffectSlot::_suspendAll()
+{
+    _internal::EFXFunctions const* efx = _internal::getEFX();
+    if (!efx)
+        return;
+    _internal::bindContext(0);
+    for (auto const& pair : _instances) {
+        EffectSlot& slot = *pair.second;
+        efx->DeleteAuxiliaryEffectSlots(1, &slot._openal_slot);
+        efx->DeleteEffects(1, &slot._openal_effect);
+        slot._openal_slot = 0;
+        slot._openal_effect = 0;
+    }
+}
+
+
+void EffectSlot::_resumeAll()
+{
+    _internal::EFXFunctions const* efx = _internal::getEFX();
+    if (!efx)
+        return;
+    _internal::bindContext(0);
+    for (auto const& pair : _instances) {
+        EffectSlot& slot = *pair.second;
+        efx->GenAuxiliaryEffectSlots(1, &slot._openal_slot);
+        efx->GenEffects(1, &slot._openal_effect);
+        slot._dirty = true;
+    }
+    _internal::updateEffects();
+}
+
+
+void EffectSlot::_markDirty()
+{
+    _dirty = true;
+    // Without audio thread, nothing would flush the change
+    if (!isThreadRunning()) {
+        _internal::updateEffects();
+    }
+}
+
+SSS_AUDIO_END;
\ No newline at end of file
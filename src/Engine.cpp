@@ -0,0 +1,249 @@
+#include "Audio/Engine.hpp"
+#include "Audio/Source.hpp"
+#include "Audio/Buffer.hpp"
+
+#include <thread>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+
+#ifdef _WIN32
+# ifndef WIN32_LEAN_AND_MEAN
+#  define WIN32_LEAN_AND_MEAN
+# endif
+# ifndef NOMINMAX
+#  define NOMINMAX
+# endif
+# include <Windows.h>
+#else
+# include <pthread.h>
+# include <sched.h>
+# include <sys/resource.h>
+#endif
+
+SSS_AUDIO_BEGIN;
+INTERNAL_BEGIN;
+
+using Clock = std::chrono::steady_clock;
+
+static std::recursive_mutex _mutex;
+
+static std::mutex _deferred_mutex;
+static std::deque<std::function<void()>> _deferred;
+
+static std::thread _thread;
+static std::atomic<bool> _thread_running{ false };
+
+static std::mutex _stats_mutex;
+static TickStats _stats;
+
+
+std::recursive_mutex& getMutex() noexcept
+{
+    return _mutex;
+}
+
+
+void defer(std::function<void()> task)
+{
+    std::lock_guard const lock(_deferred_mutex);
+    _deferred.emplace_back(std::move(task));
+}
+
+
+// Runs deferred tasks until the deadline is reached.
+// At least one task is run per tick so that the queue always progresses.
+static void _runDeferred(Clock::time_point deadline)
+{
+    bool first = true;
+    while (first || Clock::now() < deadline) {
+        std::function<void()> task;
+        {
+            std::lock_guard const lock(_deferred_mutex);
+            if (_deferred.empty())
+                return;
+            task = std::move(_deferred.front());
+            _deferred.pop_front();
+        }
+        try {
+            task();
+        }
+        catch (std::exception const& e) {
+            LOG_FUNC_ERR(e.what());
+        }
+        first = false;
+    }
+}
+
+
+static void _recordTick(Clock::duration duration, std::chrono::microseconds budget)
+{
+    double const ms = std::chrono::duration<double, std::milli>(duration).count();
+    std::lock_guard const lock(_stats_mutex);
+    ++_stats.count;
+    if (duration > budget) {
+        ++_stats.overruns;
+    }
+    _stats.last_ms = ms;
+    _stats.average_ms += (ms - _stats.average_ms) / static_cast<double>(_stats.count);
+    if (ms > _stats.max_ms) {
+        _stats.max_ms = ms;
+    }
+}
+
+
+void tick(std::chrono::microseconds budget)
+{
+    Clock::time_point const start = Clock::now();
+    Clock::time_point const deadline = start + budget;
+    // A failing phase mustn't end the audio thread
+    try {
+        std::lock_guard const lock(_mutex);
+        if (is_init()) {
+            // Disconnection failover
+            checkDevice();
+            // Streaming refills
+            Source::_updateStreams();
+            // Voice states, queues end events
+            Source::_updateStates();
+            // Fades, ramps & envelopes
+            updateAutomation();
+            // Ducking & bus gains
+            updateBuses();
+            // Reverb zones & batched effect parameters
+            updateEffects();
+        }
+    }
+    catch (std::exception const& e) {
+        LOG_FUNC_ERR(e.what());
+    }
+    // End callbacks & other deferred tasks, within budget
+    _runDeferred(deadline);
+    _recordTick(Clock::now() - start, budget);
+}
+
+
+static void _applyThreadSettings(std::thread& thread, EngineSettings const& settings)
+{
+    int const priority = std::clamp(settings.priority, -2, 2);
+#ifdef _WIN32
+    HANDLE const handle = static_cast<HANDLE>(thread.native_handle());
+    static constexpr int priorities[] = {
+        THREAD_PRIORITY_LOWEST,
+        THREAD_PRIORITY_BELOW_NORMAL,
+        THREAD_PRIORITY_NORMAL,
+        THREAD_PRIORITY_HIGHEST,
+        THREAD_PRIORITY_TIME_CRITICAL
+    };
+    if (!SetThreadPriority(handle, priorities[priority + 2])) {
+        LOG_CTX_WRN("SSS/Audio", CONTEXT_MSG("Couldn't set thread priority", priority));
+    }
+    if (settings.affinity_mask != 0
+        && SetThreadAffinityMask(handle, static_cast<DWORD_PTR>(settings.affinity_mask)) == 0)
+    {
+        LOG_CTX_WRN("SSS/Audio", "Couldn't set thread affinity");
+    }
+#else
+    pthread_t const handle = thread.native_handle();
+    if (priority > 0) {
+        // Real-time scheduling, usually requires privileges
+        sched_param param{};
+        int const min = sched_get_priority_min(SCHED_FIFO);
+        int const max = sched_get_priority_max(SCHED_FIFO);
+        param.sched_priority = priority == 2 ? max : (min + max) / 2;
+        if (pthread_setschedparam(handle, SCHED_FIFO, &param) != 0) {
+            LOG_CTX_WRN("SSS/Audio", CONTEXT_MSG("Couldn't set thread priority", priority));
+        }
+    }
+# ifdef __linux__
+    if (settings.affinity_mask != 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int i = 0; i < 64 && i < CPU_SETSIZE; ++i) {
+            if (settings.affinity_mask & (uint64_t(1) << i))
+                CPU_SET(i, &set);
+        }
+        if (pthread_setaffinity_np(handle, sizeof(set), &set) != 0) {
+            LOG_CTX_WRN("SSS/Audio", "Couldn't set thread affinity");
+        }
+    }
+# endif
+#endif
+}
+
+
+static void _threadLoop(EngineSettings settings)
+{
+#if !defined(_WIN32) && defined(__linux__)
+    // Niceness is per thread on Linux, and can only be set from within it
+    if (settings.priority < 0) {
+        int const niceness = settings.priority < -1 ? 19 : 10;
+        if (setpriority(PRIO_PROCESS, 0, niceness) != 0) {
+            LOG_CTX_WRN("SSS/Audio", CONTEXT_MSG("Couldn't set thread priority", settings.priority));
+        }
+    }
+#endif
+    Clock::time_point next = Clock::now();
+    while (_thread_running) {
+        tick(settings.tick_budget);
+        next += settings.tick_period;
+        Clock::time_point const now = Clock::now();
+        // Skip missed ticks instead of trying to catch up
+        if (next < now) {
+            next = now;
+        }
+        std::this_thread::sleep_until(next);
+    }
+}
+
+INTERNAL_END;
+
+
+void startThread(EngineSettings const& settings) try
+{
+    if (_internal::_thread_running) {
+        stopThread();
+    }
+    _internal::_thread_running = true;
+    _internal::_thread = std::thread(_internal::_threadLoop, settings);
+    _internal::_applyThreadSettings(_internal::_thread, settings);
+}
+CATCH_AND_RETHROW_FUNC_EXC;
+
+
+void stopThread()
+{
+    _internal::_thread_running = false;
+    if (_internal::_thread.joinable()) {
+        _internal::_thread.join();
+    }
+}
+
+
+bool isThreadRunning() noexcept
+{
+    return _internal::_thread_running;
+}
+
+
+void update() try
+{
+    _internal::tick(EngineSettings().tick_budget);
+}
+CATCH_AND_LOG_FUNC_EXC;
+
+
+TickStats getTickStats() noexcept
+{
+    std::lock_guard const lock(_internal::_stats_mutex);
+    return _internal::_stats;
+}
+
+
+void resetTickStats() noexcept
+{
+    std::lock_guard const lock(_internal::_stats_mutex);
+    _internal::_stats = TickStats();
+}
+
+SSS_AUDIO_END;
\ No newline at end of file
@@ -1,10 +1,104 @@
 #include "Audio/Source.hpp"
 #include "Audio/Buffer.hpp"
+#include "Audio/Analyzer.hpp"
+#include "Audio/Trace.hpp"
 
-#define RETURN_IF_NULL if (this == nullptr) return
+#include <algorithm>
+#include <cmath>
+#include <deque>
+
+// Returns if called on nullptr. Otherwise locks the engine mutex for the
+// rest of the method, as the audio thread shares the Source's state, then
+// binds the Source's context for the OpenAL calls that follow.
+#define LOCK_BIND_OR_RETURN \
+    std::unique_lock engine_lock(_internal::getMutex(), std::defer_lock); \
+    if (this != nullptr) engine_lock.lock(), _bind(); else return
 
 SSS_AUDIO_BEGIN;
 
+INTERNAL_BEGIN;
+struct Stream {
+    Stream() = default;
+    Stream(Stream const&) = delete;
+    Stream& operator=(Stream const&) = delete;
+    ~Stream()
+    {
+        if (buffers[0] != 0) {
+            alDeleteBuffers(static_cast<ALsizei>(buffers.size()), buffers.data());
+        }
+    }
+
+    // Either a file decoder, or a live producer returning the frames it wrote
+    std::unique_ptr<DecoderHandle> decoder;
+    std::function<size_t(short*, size_t)> producer;
+    ALenum format{ 0 };
+    ALsizei sample_rate{ 0 };
+    int channels{ 0 };
+    // ~125ms per buffer, 4 buffers queued
+    size_t chunk_frames{ 0 };
+    std::array<ALuint, 4> buffers{};
+    // Buffers which couldn't be filled, retried on the next ticks
+    std::vector<ALuint> idle_buffers;
+    std::vector<short> samples;
+    // Decoder position, and first frame of each queued buffer
+    int64_t next_frame{ 0 };
+    std::deque<int64_t> queued_starts;
+    // Chunk copies per buffer, fed to the Analyzer once played
+    std::array<std::vector<short>, 4> tapped;
+    bool loop{ false };
+    // Sample-accurate loop, the whole file otherwise
+    std::optional<LoopPoints> loop_points;
+    bool ended{ false };
+    // Whether playback should resume after an underrun
+    bool active{ false };
+};
+
+// Keeps a copy of the chunk being queued in given buffer, if tapped
+static void _tapChunk(Stream& stream, ALuint buffer, size_t frames, bool tapped)
+{
+    auto const it = std::find(stream.buffers.cbegin(), stream.buffers.cend(), buffer);
+    if (it == stream.buffers.cend())
+        return;
+    std::vector<short>& chunk = stream.tapped[it - stream.buffers.cbegin()];
+    chunk.clear();
+    if (tapped) {
+        chunk.assign(stream.samples.cbegin(), stream.samples.cbegin() + frames * stream.channels);
+    }
+}
+
+// Feeds the chunk which given buffer just finished playing, if tapped
+static void _feedChunk(Stream& stream, ALuint buffer, std::optional<uint32_t> analyzer_id)
+{
+    auto const it = std::find(stream.buffers.cbegin(), stream.buffers.cend(), buffer);
+    if (it == stream.buffers.cend())
+        return;
+    std::vector<short>& chunk = stream.tapped[it - stream.buffers.cbegin()];
+    Analyzer* analyzer = analyzer_id ? Analyzer::get(*analyzer_id) : nullptr;
+    if (analyzer && !chunk.empty()) {
+        analyzer->feed(chunk.data(), chunk.size() / stream.channels, stream.channels, stream.sample_rate);
+    }
+    chunk.clear();
+}
+
+struct SourceSnapshot {
+    ALint state{ AL_INITIAL };
+    ALint sample_offset{ 0 };
+    bool is_static{ false };
+    std::vector<uint32_t> buffers;  // Buffer map ids
+    int64_t stream_frame{ 0 };
+    std::vector<std::pair<ALenum, ALfloat>> floats;
+    std::vector<std::pair<ALenum, std::array<ALfloat, 3>>> vectors;
+    std::vector<std::pair<ALenum, ALint>> ints;
+};
+
+static constexpr ALenum _snapshot_floats[] = {
+    AL_PITCH, AL_MIN_GAIN, AL_MAX_GAIN, AL_REFERENCE_DISTANCE, AL_ROLLOFF_FACTOR,
+    AL_MAX_DISTANCE, AL_CONE_INNER_ANGLE, AL_CONE_OUTER_ANGLE, AL_CONE_OUTER_GAIN
+};
+static constexpr ALenum _snapshot_vectors[] = { AL_POSITION, AL_VELOCITY, AL_DIRECTION };
+static constexpr ALenum _snapshot_ints[] = { AL_SOURCE_RELATIVE, AL_LOOPING };
+INTERNAL_END;
+
 
 std::array<std::unique_ptr<Source>, 256U> Source::_instances{};
 
@@ -12,6 +106,7 @@ std::array<std::unique_ptr<Source>, 256U> Source::_instances{};
 Source::Source(uint32_t id)
     : _openal_id([]() {
         init();
+        _internal::bindContext(0);
         ALuint source;
         alGenSources(1, &source);
         if (source == 0) {
@@ -26,10 +121,17 @@ Source::Source(uint32_t id)
 
 Source::~Source()
 {
+    _internal::stopAutomation(_arr_id);
     if (_openal_id != 0) {
-        stop();
+        _bind();
+        alSourceStop(_openal_id);
         alSourcei(_openal_id, AL_BUFFER, 0);
+        _stream.reset();
         alDeleteSources(1, &_openal_id);
+        _internal::deleteFilter(_direct_filter);
+        for (ALuint& filter : _send_filters) {
+            _internal::deleteFilter(filter);
+        }
     }
 }
 
@@ -37,9 +139,11 @@ Source::~Source()
 
 Source& Source::create(uint32_t id) try
 {
+    _internal::TraceCall const trace(TraceOp::SourceCreate, id);
     if (id >= _instances.size()) {
         throw_exc(CONTEXT_MSG("Invalid ID (out of range)", id));
     }
+    std::lock_guard const lock(_internal::getMutex());
     _instances[id].reset(new Source(id));
     return *_instances.at(id);
 }
@@ -48,6 +152,7 @@ CATCH_AND_RETHROW_FUNC_EXC;
 
 Source& Source::create() try
 {
+    std::lock_guard const lock(_internal::getMutex());
     uint32_t id = 0;
     // Increment ID until no similar value is used
     while (_instances[id] && id < _instances.size()) {
@@ -63,18 +168,104 @@ CATCH_AND_RETHROW_FUNC_EXC;
 
 Source* Source::get(uint32_t id) noexcept
 {
+    if (id >= _instances.size())
+        return nullptr;
     return _instances[id].get();
 }
 
 
 void Source::remove(uint32_t id)
 {
+    _internal::TraceCall const trace(TraceOp::SourceRemove, id);
+    std::lock_guard const lock(_internal::getMutex());
     _instances[id].reset();
 }
 
 
+void Source::setValues(std::vector<SourceValue> const& values)
+{
+    _internal::TraceCall const trace(TraceOp::SourceSetValues, values);
+    std::lock_guard const lock(_internal::getMutex());
+    // Updates are deferred per context, each being batched separately
+    _internal::DeferredUpdates batch;
+    for (SourceValue const& value : values) {
+        Source* source = get(value.id);
+        if (!source)
+            continue;
+        source->_bind();
+        batch.add(source->_context_id);
+        switch (value.param) {
+        case SourceParam::Gain:
+            source->setGain(value.value);
+            break;
+        case SourceParam::Pitch:
+            source->setPropertyFloat(AL_PITCH, value.value);
+            break;
+        case SourceParam::Looping:
+            source->setLooping(value.value != 0.f);
+            break;
+        case SourceParam::X:
+        case SourceParam::Y:
+        case SourceParam::Z: {
+            _internal::stopAutomation(source->_arr_id, _internal::Automated::Position);
+            std::array<ALfloat, 3> position;
+            alGetSourcefv(source->_openal_id, AL_POSITION, position.data());
+            position[static_cast<size_t>(value.param) - static_cast<size_t>(SourceParam::X)] = value.value;
+            alSourcefv(source->_openal_id, AL_POSITION, position.data());
+            break;
+        }
+        case SourceParam::Offset:
+            alSourcef(source->_openal_id, AL_SEC_OFFSET, value.value);
+            break;
+        case SourceParam::Playing:
+            value.value != 0.f ? source->play() : source->pause();
+            break;
+        }
+    }
+}
+
+
+void Source::getValues(std::vector<SourceValue>& values)
+{
+    std::lock_guard const lock(_internal::getMutex());
+    for (SourceValue& value : values) {
+        Source const* source = get(value.id);
+        value.value = 0.f;
+        if (!source)
+            continue;
+        source->_bind();
+        switch (value.param) {
+        case SourceParam::Gain:
+            value.value = source->_gain;
+            break;
+        case SourceParam::Pitch:
+            alGetSourcef(source->_openal_id, AL_PITCH, &value.value);
+            break;
+        case SourceParam::Looping:
+            value.value = source->isLooping() ? 1.f : 0.f;
+            break;
+        case SourceParam::X:
+        case SourceParam::Y:
+        case SourceParam::Z: {
+            std::array<ALfloat, 3> position;
+            alGetSourcefv(source->_openal_id, AL_POSITION, position.data());
+            value.value = position[static_cast<size_t>(value.param) - static_cast<size_t>(SourceParam::X)];
+            break;
+        }
+        case SourceParam::Offset:
+            alGetSourcef(source->_openal_id, AL_SEC_OFFSET, &value.value);
+            break;
+        case SourceParam::Playing:
+            value.value = source->_getState() == AL_PLAYING ? 1.f : 0.f;
+            break;
+        }
+    }
+}
+
+
 void Source::clearAll() noexcept
 {
+    std::lock_guard const lock(_internal::getMutex());
     for (auto& ptr : _instances) {
         ptr.reset();
     }
@@ -83,12 +274,15 @@ void Source::clearAll() noexcept
 
 void Source::useBuffer(uint32_t id)
 {
-    RETURN_IF_NULL;
+    LOCK_BIND_OR_RETURN;
+    _internal::TraceCall const trace(TraceOp::SourceUseBuffer, _arr_id, id);
     Buffer* buffer = Buffer::get(id);
     if (!buffer) {
         LOG_CTX_WRN("SSS/Audio", "Found no Buffer to use at given ID.");
         return;
     }
+    std::lock_guard const lock(_internal::getMutex());
+    _endStream();
     bool was_playing = false;
     if (!isStopped()) {
         was_playing = isPlaying();
@@ -105,7 +299,10 @@ void Source::useBuffer(uint32_t id)
 
 void Source::queueBuffers(std::vector<uint32_t> ids)
 {
-    RETURN_IF_NULL;
+    LOCK_BIND_OR_RETURN;
+    _internal::TraceCall const trace(TraceOp::SourceQueueBuffers, _arr_id, ids);
+    std::lock_guard const lock(_internal::getMutex());
+    _endStream();
     // OpenAL IDs (to be filled)
     std::vector<ALuint> openal_ids;
     openal_ids.reserve(ids.size() + 1);
@@ -162,6 +359,10 @@ void Source::queueBuffers(std::vector<uint32_t> ids)
 
 void Source::detachBuffers()
 {
+    LOCK_BIND_OR_RETURN;
+    _internal::TraceCall const trace(TraceOp::SourceDetachBuffers, _arr_id);
+    std::lock_guard const lock(_internal::getMutex());
+    _endStream();
     stop();
     alSourcei(_openal_id, AL_BUFFER, 0);
     _buffer_ids.clear();
@@ -188,76 +389,435 @@ catch (std::exception const& e) {
 }
 
 
+void Source::streamFile(std::string const& filename) try
+{
+    LOCK_BIND_OR_RETURN;
+    _internal::TraceCall const trace(TraceOp::SourceStreamFile, _arr_id, filename);
+    std::lock_guard const lock(_internal::getMutex());
+    detachBuffers();
+
+    auto stream = std::make_unique<_internal::Stream>();
+    stream->decoder = _internal::openDecoder(filename);
+    AudioInfo const info = stream->decoder->getInfo();
+    stream->format = _internal::getFormat(info.channels);
+    stream->sample_rate = static_cast<ALsizei>(info.sample_rate);
+    stream->channels = info.channels;
+    stream->chunk_frames = std::max(static_cast<size_t>(info.sample_rate) / 8, size_t(1024));
+    stream->samples.resize(stream->chunk_frames * info.channels);
+    stream->loop = isLooping();
+    stream->loop_points = stream->decoder->getLoopPoints();
+    _startStream(std::move(stream));
+}
+CATCH_AND_LOG_METHOD_EXC;
+
+
+void Source::streamCapture(uint32_t capture_id) try
+{
+    LOCK_BIND_OR_RETURN;
+    std::lock_guard const lock(_internal::getMutex());
+    Capture const* capture = Capture::get(capture_id);
+    if (!capture) {
+        LOG_METHOD_CTX_WRN("Couldn't find a Capture with given ID", capture_id);
+        return;
+    }
+    detachBuffers();
+
+    CaptureSettings const& settings = capture->getSettings();
+    auto stream = std::make_unique<_internal::Stream>();
+    stream->producer = [capture_id](short* samples, size_t frames) -> size_t {
+        Capture* capture = Capture::get(capture_id);
+        return capture ? capture->read(samples, frames) : 0;
+    };
+    stream->format = _internal::getFormat(settings.channels);
+    stream->sample_rate = static_cast<ALsizei>(settings.frequency);
+    stream->channels = settings.channels;
+    // One period per buffer, for the lowest latency
+    stream->chunk_frames = static_cast<size_t>(std::max(settings.period_frames, 1));
+    stream->samples.resize(stream->chunk_frames * settings.channels);
+    _startStream(std::move(stream));
+}
+CATCH_AND_LOG_METHOD_EXC;
+
+
+void Source::_startStream(std::unique_ptr<_internal::Stream> stream)
+{
+    alGenBuffers(static_cast<ALsizei>(stream->buffers.size()), stream->buffers.data());
+    if (ALenum const err = alGetError(); err != AL_NO_ERROR) {
+        stream->buffers.fill(0);
+        SSS::throw_exc("Couldn't generate stream buffers: " + _internal::getALErrorString(err));
+    }
+    // AL_LOOPING would loop the queue, not the file
+    alSourcei(_openal_id, AL_LOOPING, AL_FALSE);
+    _stream = std::move(stream);
+    _rewindStream();
+}
+
+
 void Source::play()
 {
-    RETURN_IF_NULL;
+    LOCK_BIND_OR_RETURN;
+    _internal::TraceCall const trace(TraceOp::SourcePlay, _arr_id);
+    // Finished streams restart from the beginning, as static Buffers do
+    if (_stream && _stream->ended && !_stream->producer) {
+        std::lock_guard const lock(_internal::getMutex());
+        ALint queued = 0;
+        alGetSourcei(_openal_id, AL_BUFFERS_QUEUED, &queued);
+        if (queued == 0) {
+            _rewindStream();
+        }
+    }
+    // Playback starts once the Bus resumes
+    if (Bus* pausing = _getPausingBus()) {
+        std::lock_guard const lock(_internal::getMutex());
+        if (!isPaused()) {
+            alSourcePlay(_openal_id);
+            alSourcePause(_openal_id);
+        }
+        auto& paused = pausing->_paused_sources;
+        if (std::find(paused.cbegin(), paused.cend(), _arr_id) == paused.cend()) {
+            paused.push_back(_arr_id);
+        }
+        return;
+    }
+    if (_stream) {
+        _stream->active = true;
+    }
     alSourcePlay(_openal_id);
 }
 
 
 void Source::pause()
 {
-    RETURN_IF_NULL;
+    LOCK_BIND_OR_RETURN;
+    _internal::TraceCall const trace(TraceOp::SourcePause, _arr_id);
+    if (_stream) {
+        _stream->active = false;
+    }
     alSourcePause(_openal_id);
 }
 
 
 void Source::stop()
 {
-    RETURN_IF_NULL;
+    LOCK_BIND_OR_RETURN;
+    _internal::TraceCall const trace(TraceOp::SourceStop, _arr_id);
     alSourceStop(_openal_id);
+    // Explicit stops don't call the end callback
+    _last_state = AL_STOPPED;
+    if (_stream) {
+        std::lock_guard const lock(_internal::getMutex());
+        _rewindStream();
+    }
 }
 
 
 bool Source::isPlaying() const noexcept
 {
-    RETURN_IF_NULL false;
+    LOCK_BIND_OR_RETURN false;
     return _getState() == AL_PLAYING;
 }
 
 
 bool Source::isPaused() const noexcept
 {
-    RETURN_IF_NULL false;
+    LOCK_BIND_OR_RETURN false;
     return _getState() == AL_PAUSED;
 }
 
 
 bool Source::isStopped() const noexcept
 {
-    RETURN_IF_NULL false;
+    LOCK_BIND_OR_RETURN false;
     ALint const status = _getState();
     return status == AL_STOPPED || status == AL_INITIAL;
 }
 
 
+double Source::getLatency() const
+{
+    LOCK_BIND_OR_RETURN 0.;
+    static LPALGETSOURCEDVSOFT const get_sourcedv = alIsExtensionPresent("AL_SOFT_source_latency")
+        ? reinterpret_cast<LPALGETSOURCEDVSOFT>(alGetProcAddress("alGetSourcedvSOFT"))
+        : nullptr;
+    if (!get_sourcedv)
+        return 0.;
+    // Offset & latency
+    ALdouble values[2] = { 0., 0. };
+    get_sourcedv(_openal_id, AL_SEC_OFFSET_LATENCY_SOFT, values);
+    return values[1];
+}
+
+
+void Source::setEndCallback(std::function<void(uint32_t)> callback)
+{
+    LOCK_BIND_OR_RETURN;
+    std::lock_guard const lock(_internal::getMutex());
+    _on_end = std::move(callback);
+}
+
+
+void Source::setBus(std::string const& name)
+{
+    LOCK_BIND_OR_RETURN;
+    _internal::TraceCall const trace(TraceOp::SourceSetBus, _arr_id, name);
+    std::lock_guard const lock(_internal::getMutex());
+    Bus const* bus = nullptr;
+    if (!name.empty()) {
+        bus = Bus::get(name);
+        if (!bus) {
+            LOG_CTX_WRN("SSS/Audio", CONTEXT_MSG("Found no Bus with given name", name));
+            return;
+        }
+    }
+    _bus = name;
+    Bus::_hierarchy_changed = true;
+    _bus_gain = bus ? bus->getEffectiveGain() : 1.f;
+    _applyGain();
+    _applyBusEffectSlot();
+}
+
+
+void Source::setDirectFilter(Filter const& filter) try
+{
+    LOCK_BIND_OR_RETURN;
+    _internal::TraceCall const trace(TraceOp::SourceSetDirectFilter, _arr_id,
+        static_cast<int32_t>(filter.type), filter.gain, filter.gain_hf, filter.gain_lf);
+    if (!_internal::getEFX()) {
+        LOG_CTX_WRN("SSS/Audio", "EFX isn't supported, filter ignored.");
+        return;
+    }
+    std::lock_guard const lock(_internal::getMutex());
+    alSourcei(_openal_id, AL_DIRECT_FILTER,
+        static_cast<ALint>(_internal::makeFilter(_direct_filter, filter)));
+    _direct_filter_settings = filter;
+}
+CATCH_AND_LOG_METHOD_EXC;
+
+
+void Source::sendTo(uint32_t slot_id, ALint send, Filter const& filter) try
+{
+    LOCK_BIND_OR_RETURN;
+    _internal::TraceCall const trace(TraceOp::SourceSendTo, _arr_id, slot_id, send,
+        static_cast<int32_t>(filter.type), filter.gain, filter.gain_hf, filter.gain_lf);
+    if (!_internal::getEFX()) {
+        LOG_CTX_WRN("SSS/Audio", "EFX isn't supported, send ignored.");
+        return;
+    }
+    std::lock_guard const lock(_internal::getMutex());
+    if (_context_id != 0) {
+        LOG_CTX_WRN("SSS/Audio", "EffectSlots only exist on the main context, send ignored.");
+        return;
+    }
+    EffectSlot const* slot = EffectSlot::get(slot_id);
+    if (!slot) {
+        LOG_CTX_WRN("SSS/Audio", "Found no EffectSlot to send to at given ID.");
+        return;
+    }
+    ALCint max_sends = 0;
+    alcGetIntegerv(alcGetContextsDevice(alcGetCurrentContext()), ALC_MAX_AUXILIARY_SENDS, 1, &max_sends);
+    if (send < 0 || send >= max_sends || send >= static_cast<ALint>(_sends.size())) {
+        throw_exc(CONTEXT_MSG("Invalid send (out of range)", send));
+    }
+    ALuint const filter_id = _internal::makeFilter(_send_filters[send], filter);
+    alSource3i(_openal_id, AL_AUXILIARY_SEND_FILTER,
+        static_cast<ALint>(slot->_openal_slot), send, static_cast<ALint>(filter_id));
+    _sends[send] = slot_id;
+    _send_filter_settings[send] = filter;
+    if (send == 0) {
+        _bus_send = false;
+    }
+}
+CATCH_AND_LOG_METHOD_EXC;
+
+
+void Source::clearSend(ALint send)
+{
+    LOCK_BIND_OR_RETURN;
+    _internal::TraceCall const trace(TraceOp::SourceClearSend, _arr_id, send);
+    if (send < 0 || send >= static_cast<ALint>(_sends.size()) || !_sends[send])
+        return;
+    std::lock_guard const lock(_internal::getMutex());
+    alSource3i(_openal_id, AL_AUXILIARY_SEND_FILTER, AL_EFFECTSLOT_NULL, send, AL_FILTER_NULL);
+    _sends[send].reset();
+    if (send == 0) {
+        _bus_send = false;
+    }
+}
+
+
+void Source::setContext(uint32_t context_id)
+{
+    LOCK_BIND_OR_RETURN;
+    _internal::TraceCall const trace(TraceOp::SourceSetContext, _arr_id, context_id);
+    std::lock_guard const lock(_internal::getMutex());
+    if (!_internal::hasContext(context_id)) {
+        LOG_METHOD_CTX_WRN("Couldn't find a context with given ID", context_id);
+        return;
+    }
+    if (context_id == _context_id)
+        return;
+    // Same as a device migration, on a single Source
+    _suspend();
+    _context_id = context_id;
+    if (_context_id != 0) {
+        _sends.fill(std::nullopt);
+        _bus_send = false;
+    }
+    _resume();
+    if (_context_id == 0) {
+        _applyBusEffectSlot();
+    }
+}
+
+
+void Source::setAnalyzer(std::optional<uint32_t> analyzer_id)
+{
+    LOCK_BIND_OR_RETURN;
+    std::lock_guard const lock(_internal::getMutex());
+    if (analyzer_id && !Analyzer::get(*analyzer_id)) {
+        LOG_METHOD_CTX_WRN("Couldn't find an Analyzer with given ID", *analyzer_id);
+        return;
+    }
+    _analyzer_id = analyzer_id;
+}
+
+
 void Source::setVolume(int percentage)
 {
-    setPropertyFloat(AL_GAIN, static_cast<float>(percentage) / 100.f);
+    setGain(static_cast<float>(percentage) / 100.f);
 }
 
 
 int Source::getVolume() const
 {
-    return static_cast<int>(getPropertyFloat(AL_GAIN) * 100.f);
+    return static_cast<int>(std::round(getGain() * 100.f));
+}
+
+
+void Source::setGain(float gain)
+{
+    LOCK_BIND_OR_RETURN;
+    _internal::TraceCall const trace(TraceOp::SourceSetGain, _arr_id, gain);
+    _internal::stopAutomation(_arr_id, _internal::Automated::Gain);
+    _gain = gain;
+    _applyGain();
+}
+
+
+float Source::getGain() const noexcept
+{
+    LOCK_BIND_OR_RETURN 0.f;
+    return _gain;
+}
+
+
+void Source::fadeGain(float target, float seconds, Curve curve)
+{
+    LOCK_BIND_OR_RETURN;
+    _internal::TraceCall const trace(TraceOp::SourceFadeGain, _arr_id, target, seconds, static_cast<int32_t>(curve));
+    _internal::automate(_arr_id, _internal::Automated::Gain, { _gain, 0.f, 0.f },
+        { { seconds, { target, 0.f, 0.f }, curve } });
+}
+
+
+void Source::rampPitch(float target, float seconds, Curve curve)
+{
+    LOCK_BIND_OR_RETURN;
+    _internal::TraceCall const trace(TraceOp::SourceRampPitch, _arr_id, target, seconds, static_cast<int32_t>(curve));
+    _internal::automate(_arr_id, _internal::Automated::Pitch, { getPropertyFloat(AL_PITCH), 0.f, 0.f },
+        { { seconds, { target, 0.f, 0.f }, curve } });
+}
+
+
+void Source::moveTo(float x, float y, float z, float seconds, Curve curve)
+{
+    LOCK_BIND_OR_RETURN;
+    _internal::TraceCall const trace(TraceOp::SourceMoveTo, _arr_id, x, y, z, seconds,
+        static_cast<int32_t>(curve));
+    std::array<float, 3> start;
+    alGetSource3f(_openal_id, AL_POSITION, &start[0], &start[1], &start[2]);
+    _internal::automate(_arr_id, _internal::Automated::Position, start,
+        { { seconds, { x, y, z }, curve } });
+}
+
+
+// Converts absolute envelope times into segment durations
+static std::vector<_internal::Segment> _toSegments(std::vector<EnvelopePoint> const& points, Curve curve)
+{
+    std::vector<_internal::Segment> segments;
+    segments.reserve(points.size());
+    float time = 0.f;
+    for (EnvelopePoint const& point : points) {
+        segments.push_back({ std::max(point.time - time, 0.f), { point.value, 0.f, 0.f }, curve });
+        time = std::max(point.time, time);
+    }
+    return segments;
+}
+
+
+void Source::setGainEnvelope(std::vector<EnvelopePoint> const& points, Curve curve)
+{
+    LOCK_BIND_OR_RETURN;
+    _internal::TraceCall const trace(TraceOp::SourceSetGainEnvelope, _arr_id, points, static_cast<int32_t>(curve));
+    _internal::automate(_arr_id, _internal::Automated::Gain, { _gain, 0.f, 0.f },
+        _toSegments(points, curve));
+}
+
+
+void Source::setPitchEnvelope(std::vector<EnvelopePoint> const& points, Curve curve)
+{
+    LOCK_BIND_OR_RETURN;
+    _internal::TraceCall const trace(TraceOp::SourceSetPitchEnvelope, _arr_id, points, static_cast<int32_t>(curve));
+    _internal::automate(_arr_id, _internal::Automated::Pitch, { getPropertyFloat(AL_PITCH), 0.f, 0.f },
+        _toSegments(points, curve));
+}
+
+
+void Source::stopAutomation()
+{
+    LOCK_BIND_OR_RETURN;
+    _internal::TraceCall const trace(TraceOp::SourceStopAutomation, _arr_id);
+    _internal::stopAutomation(_arr_id);
 }
 
 
 void Source::setLooping(bool enable)
 {
+    LOCK_BIND_OR_RETURN;
+    _internal::TraceCall const trace(TraceOp::SourceSetLooping, _arr_id, enable);
+    if (_stream) {
+        _stream->loop = enable;
+        return;
+    }
     setPropertyInt(AL_LOOPING, static_cast<int>(enable));
 }
 
 
+void Source::setStreamLoopPoints(std::optional<LoopPoints> loop)
+{
+    LOCK_BIND_OR_RETURN;
+    std::lock_guard const lock(_internal::getMutex());
+    if (!_stream) {
+        LOG_METHOD_CTX_WRN("Source isn't streaming", _arr_id);
+        return;
+    }
+    _stream->loop_points = loop;
+}
+
+
 bool Source::isLooping() const
 {
+    LOCK_BIND_OR_RETURN false;
+    if (_stream) {
+        return _stream->loop;
+    }
     return static_cast<bool>(getPropertyInt(AL_LOOPING));
 }
 
 
 ALint Source::getPropertyInt(ALenum param) const
 {
-    RETURN_IF_NULL 0;
+    LOCK_BIND_OR_RETURN 0;
     ALint ret;
     alGetSourcei(_openal_id, param, &ret);
     return ret;;
@@ -266,14 +826,18 @@ ALint Source::getPropertyInt(ALenum param) const
 
 void Source::setPropertyInt(ALenum param, ALint value)
 {
-    RETURN_IF_NULL;
+    LOCK_BIND_OR_RETURN;
+    _internal::TraceCall const trace(TraceOp::SourceSetPropertyInt, _arr_id, param, value);
     alSourcei(_openal_id, param, value);
 }
 
 
 ALfloat Source::getPropertyFloat(ALenum param) const
 {
-    RETURN_IF_NULL 0.f;
+    LOCK_BIND_OR_RETURN 0.f;
+    if (param == AL_GAIN) {
+        return _gain;
+    }
     ALfloat ret;
     alGetSourcef(_openal_id, param, &ret);
     return ret;;
@@ -282,7 +846,15 @@ ALfloat Source::getPropertyFloat(ALenum param) const
 
 void Source::setPropertyFloat(ALenum param, ALfloat value)
 {
-    RETURN_IF_NULL;
+    LOCK_BIND_OR_RETURN;
+    _internal::TraceCall const trace(TraceOp::SourceSetPropertyFloat, _arr_id, param, value);
+    if (param == AL_GAIN) {
+        setGain(value);
+        return;
+    }
+    if (param == AL_PITCH) {
+        _internal::stopAutomation(_arr_id, _internal::Automated::Pitch);
+    }
     alSourcef(_openal_id, param, value);
 }
 
@@ -290,7 +862,7 @@ void Source::setPropertyFloat(ALenum param, ALfloat value)
 
 ALint Source::_getType() const noexcept
 {
-    RETURN_IF_NULL 0;
+    LOCK_BIND_OR_RETURN 0;
     ALint type;
     alGetSourcei(_openal_id, AL_SOURCE_TYPE, &type);
     return type;
@@ -299,7 +871,7 @@ ALint Source::_getType() const noexcept
 
 ALint Source::_getState() const noexcept
 {
-    RETURN_IF_NULL 0;
+    LOCK_BIND_OR_RETURN 0;
     ALint state;
     alGetSourcei(_openal_id, AL_SOURCE_STATE, &state);
     return state;
@@ -308,7 +880,7 @@ ALint Source::_getState() const noexcept
 
 void Source::_removeBuffer(ALuint id)
 {
-    RETURN_IF_NULL;
+    LOCK_BIND_OR_RETURN;
     size_t const size_before = _buffer_ids.size();
     _buffer_ids.erase(
         std::remove_if(
@@ -330,4 +902,369 @@ void Source::_removeBuffer(ALuint id)
     }
 }
 
+
+
+void Source::_updateStates()
+{
+    for (auto const& source : _instances) {
+        if (!source)
+            continue;
+        source->_bind();
+        ALint const state = source->_getState();
+        // Starved streams are resumed by _updateStreams(), they didn't end
+        if (state == AL_STOPPED && source->_stream && source->_stream->active)
+            continue;
+        if (source->_last_state == AL_PLAYING && state == AL_STOPPED && source->_on_end) {
+            // Dispatched within the tick budget
+            _internal::defer([callback = source->_on_end, id = source->_arr_id]() {
+                callback(id);
+            });
+        }
+        source->_last_state = state;
+    }
+}
+
+
+
+void Source::_updateStreams()
+{
+    for (auto const& source : _instances) {
+        if (!source || !source->_stream)
+            continue;
+        source->_bind();
+        _internal::Stream& stream = *source->_stream;
+        ALuint const id = source->_openal_id;
+
+        ALint processed = 0;
+        alGetSourcei(id, AL_BUFFERS_PROCESSED, &processed);
+        while (processed-- > 0) {
+            ALuint buffer;
+            alSourceUnqueueBuffers(id, 1, &buffer);
+            _internal::_feedChunk(stream, buffer, source->_analyzer_id);
+            if (!stream.queued_starts.empty()) {
+                stream.queued_starts.pop_front();
+            }
+            if (source->_fillStreamBuffer(buffer)) {
+                alSourceQueueBuffers(id, 1, &buffer);
+            }
+            else {
+                stream.idle_buffers.push_back(buffer);
+            }
+        }
+        // Live streams may have new samples, files may have been rewound
+        while (!stream.ended && !stream.idle_buffers.empty()
+            && source->_fillStreamBuffer(stream.idle_buffers.back()))
+        {
+            alSourceQueueBuffers(id, 1, &stream.idle_buffers.back());
+            stream.idle_buffers.pop_back();
+        }
+
+        // Resume after an underrun, as OpenAL stops starved sources
+        ALint queued = 0;
+        alGetSourcei(id, AL_BUFFERS_QUEUED, &queued);
+        if (stream.active && queued > 0 && source->_getState() == AL_STOPPED) {
+            alSourcePlay(id);
+        }
+        else if (queued == 0 && !stream.producer) {
+            stream.active = false;
+        }
+    }
+}
+
+
+bool Source::_fillStreamBuffer(ALuint buffer)
+{
+    _internal::Stream& stream = *_stream;
+    if (stream.producer) {
+        size_t const frames = stream.producer(stream.samples.data(), stream.chunk_frames);
+        if (frames == 0)
+            return false;
+        stream.queued_starts.push_back(stream.next_frame);
+        stream.next_frame += frames;
+        _internal::_tapChunk(stream, buffer, frames, _analyzer_id.has_value());
+        alBufferData(buffer, stream.format, stream.samples.data(),
+            static_cast<ALsizei>(frames * stream.channels * sizeof(short)), stream.sample_rate);
+        return true;
+    }
+    std::optional<LoopPoints> const& points = stream.loop_points;
+    int64_t start = stream.next_frame;
+    size_t frames = 0;
+    int empty_wraps = 0;
+    while (!stream.ended && frames < stream.chunk_frames) {
+        if (frames == 0) {
+            start = stream.next_frame;
+        }
+        // Stop reading at the loop end, if not past it already
+        size_t wanted = stream.chunk_frames - frames;
+        bool const in_loop = stream.loop && points && stream.next_frame < points->end;
+        if (in_loop) {
+            wanted = std::min(wanted, static_cast<size_t>(points->end - stream.next_frame));
+        }
+        size_t const read = stream.decoder->read(&stream.samples[frames * stream.channels], wanted);
+        frames += read;
+        stream.next_frame += read;
+        if (read != 0 && !(in_loop && stream.next_frame >= points->end))
+            continue;
+        // Loop back, or end the stream. Empty or unreadable files would
+        // wrap forever, so two wraps in a row without data end it.
+        int64_t const target = stream.loop && points ? points->start : 0;
+        if (!stream.loop || ++empty_wraps > 1 || !stream.decoder->seek(target)) {
+            stream.ended = true;
+        }
+        stream.next_frame = target;
+        if (read != 0) {
+            empty_wraps = 0;
+        }
+        // Each buffer holds contiguous frames, for playback positions
+        if (frames != 0)
+            break;
+    }
+    if (frames == 0)
+        return false;
+    stream.queued_starts.push_back(start);
+    _internal::_tapChunk(stream, buffer, frames, _analyzer_id.has_value());
+    alBufferData(buffer, stream.format, stream.samples.data(),
+        static_cast<ALsizei>(frames * stream.channels * sizeof(short)), stream.sample_rate);
+    return true;
+}
+
+
+void Source::_rewindStream(int64_t frame)
+{
+    alSourceStop(_openal_id);
+    alSourcei(_openal_id, AL_BUFFER, 0);
+    _stream->active = false;
+    _stream->ended = false;
+    _stream->queued_starts.clear();
+    for (std::vector<short>& chunk : _stream->tapped) {
+        chunk.clear();
+    }
+    _stream->idle_buffers.clear();
+    // Live streams can't seek, their position only grows
+    if (_stream->decoder) {
+        if (_stream->decoder->seek(frame)) {
+            _stream->next_frame = frame;
+        }
+        else {
+            LOG_CTX_WRN("SSS/Audio", CONTEXT_MSG("Stream couldn't seek to frame", frame));
+        }
+    }
+    for (ALuint const buffer : _stream->buffers) {
+        if (_fillStreamBuffer(buffer)) {
+            alSourceQueueBuffers(_openal_id, 1, &buffer);
+        }
+        else {
+            _stream->idle_buffers.push_back(buffer);
+        }
+    }
+}
+
+
+void Source::_endStream()
+{
+    if (!_stream)
+        return;
+    alSourceStop(_openal_id);
+    alSourcei(_openal_id, AL_BUFFER, 0);
+    _stream.reset();
+}
+
+
+void Source::_applyGain()
+{
+    _bind();
+    alSourcef(_openal_id, AL_GAIN, _gain * _bus_gain);
+}
+
+
+void Source::_applyBusEffectSlot()
+{
+    if (_context_id != 0)
+        return;
+    // Sends the user set on send 0 take precedence
+    if (_sends[0] && !_bus_send)
+        return;
+    Bus const* bus = Bus::get(_bus);
+    std::optional<uint32_t> const slot = bus ? bus->getInheritedEffectSlot() : std::nullopt;
+    if (slot) {
+        sendTo(*slot, 0);
+        _bus_send = _sends[0].has_value();
+    }
+    else if (_bus_send) {
+        clearSend(0);
+    }
+}
+
+
+void Source::_suspendAll()
+{
+    for (auto const& source : _instances) {
+        if (source) {
+            source->_suspend();
+        }
+    }
+}
+
+
+void Source::_resumeAll()
+{
+    for (auto const& source : _instances) {
+        if (source) {
+            source->_resume();
+        }
+    }
+}
+
+
+void Source::_suspend()
+{
+    _bind();
+    auto snapshot = std::make_unique<_internal::SourceSnapshot>();
+    ALuint const id = _openal_id;
+    snapshot->state = _getState();
+    snapshot->is_static = _getType() == AL_STATIC;
+    alGetSourcei(id, AL_SAMPLE_OFFSET, &snapshot->sample_offset);
+    snapshot->buffers = getBufferIDs();
+    for (ALenum const param : _internal::_snapshot_floats) {
+        ALfloat value;
+        alGetSourcef(id, param, &value);
+        snapshot->floats.emplace_back(param, value);
+    }
+    for (ALenum const param : _internal::_snapshot_vectors) {
+        std::array<ALfloat, 3> value;
+        alGetSource3f(id, param, &value[0], &value[1], &value[2]);
+        snapshot->vectors.emplace_back(param, value);
+    }
+    for (ALenum const param : _internal::_snapshot_ints) {
+        ALint value;
+        alGetSourcei(id, param, &value);
+        snapshot->ints.emplace_back(param, value);
+    }
+    if (_stream) {
+        // Frame currently heard, from the oldest queued buffer
+        _internal::Stream& stream = *_stream;
+        int64_t frame = stream.queued_starts.empty() ? stream.next_frame
+            : stream.queued_starts.front() + snapshot->sample_offset;
+        int64_t const total = stream.decoder ? stream.decoder->getInfo().frames : 0;
+        std::optional<LoopPoints> const& points = stream.loop_points;
+        // Queued buffers may have wrapped at the loop end
+        if (stream.loop && points && points->end > points->start && frame >= points->end) {
+            frame = points->start + (frame - points->start) % (points->end - points->start);
+        }
+        else if (total > 0 && frame >= total) {
+            frame %= total;
+        }
+        snapshot->stream_frame = frame;
+        snapshot->state = stream.active ? AL_PLAYING : snapshot->state;
+    }
+
+    // Free OpenAL objects
+    alSourceStop(id);
+    alSourcei(id, AL_BUFFER, 0);
+    alDeleteSources(1, &_openal_id);
+    _openal_id = 0;
+    _buffer_ids.clear();
+    if (_stream) {
+        alDeleteBuffers(static_cast<ALsizei>(_stream->buffers.size()),
+            _stream->buffers.data());
+        _stream->buffers.fill(0);
+    }
+    _internal::deleteFilter(_direct_filter);
+    for (ALuint& filter : _send_filters) {
+        _internal::deleteFilter(filter);
+    }
+    _snapshot = std::move(snapshot);
+}
+
+
+void Source::_resume()
+{
+    _bind();
+    if (!_snapshot)
+        return;
+    std::unique_ptr<_internal::SourceSnapshot> snapshot = std::move(_snapshot);
+
+    alGenSources(1, &_openal_id);
+    if (_openal_id == 0) {
+        LOG_FUNC_ERR("Couldn't regenerate an OpenAL source: "
+            + _internal::getALErrorString(alGetError()));
+        return;
+    }
+    ALuint const id = _openal_id;
+    for (auto const& [param, value] : snapshot->floats) {
+        alSourcef(id, param, value);
+    }
+    for (auto const& [param, value] : snapshot->vectors) {
+        alSource3f(id, param, value[0], value[1], value[2]);
+    }
+    for (auto const& [param, value] : snapshot->ints) {
+        alSourcei(id, param, value);
+    }
+    _applyGain();
+
+    // Effects
+    if (_internal::getEFX()) {
+        alSourcei(id, AL_DIRECT_FILTER, static_cast<ALint>(
+            _internal::makeFilter(_direct_filter, _direct_filter_settings)));
+        auto const sends = _sends;
+        bool const bus_send = _bus_send;
+        for (size_t i = 0; i < sends.size(); ++i) {
+            _sends[i].reset();
+            if (sends[i]) {
+                sendTo(*sends[i], static_cast<ALint>(i), _send_filter_settings[i]);
+            }
+        }
+        _bus_send = bus_send && _sends[0].has_value();
+    }
+
+    // Buffers & playback position
+    if (_stream) {
+        _internal::Stream& stream = *_stream;
+        alGenBuffers(static_cast<ALsizei>(stream.buffers.size()), stream.buffers.data());
+        alSourcei(id, AL_LOOPING, AL_FALSE);
+        _rewindStream(snapshot->stream_frame);
+    }
+    else {
+        for (uint32_t const buffer_id : snapshot->buffers) {
+            if (Buffer const* buffer = Buffer::get(buffer_id)) {
+                _buffer_ids.push_back(buffer->_openal_id);
+            }
+        }
+        if (snapshot->is_static && _buffer_ids.size() == 1) {
+            alSourcei(id, AL_BUFFER, static_cast<ALint>(_buffer_ids[0]));
+        }
+        else if (!_buffer_ids.empty()) {
+            alSourceQueueBuffers(id, static_cast<ALsizei>(_buffer_ids.size()),
+                _buffer_ids.data());
+        }
+        if (snapshot->state == AL_PLAYING || snapshot->state == AL_PAUSED) {
+            alSourcei(id, AL_SAMPLE_OFFSET, snapshot->sample_offset);
+        }
+    }
+    switch (snapshot->state) {
+    case AL_PLAYING:
+        if (_stream) {
+            _stream->active = true;
+        }
+        alSourcePlay(id);
+        break;
+    case AL_PAUSED:
+        alSourcePlay(id);
+        alSourcePause(id);
+        break;
+    default:
+        break;
+    }
+}
+
+
+Bus* Source::_getPausingBus() const noexcept
+{
+    for (Bus* bus = Bus::get(_bus); bus != nullptr; bus = Bus::get(bus->getParent())) {
+        if (bus->_paused)
+            return bus;
+    }
+    return nullptr;
+}
+
 SSS_AUDIO_END;
\ No newline at end of file
@@ -0,0 +1,841 @@
+#include "Audio/Trace.hpp"
+#include "Audio/Source.hpp"
+#include "Audio/Buffer.hpp"
+
+#include <cstring>
+#include <fstream>
+
+#ifdef SSS_AUDIO_COUNT_ALLOCATIONS
+#include <cstdlib>
+#include <new>
+
+static std::atomic<uint64_t> _allocations{ 0 };
+static std::atomic<uint64_t> _allocated_bytes{ 0 };
+
+void* operator new(std::size_t size)
+{
+    _allocations.fetch_add(1, std::memory_order_relaxed);
+    _allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size != 0 ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+#endif // SSS_AUDIO_COUNT_ALLOCATIONS
+
+SSS_AUDIO_BEGIN;
+
+INTERNAL_BEGIN;
+
+using Clock = std::chrono::steady_clock;
+
+// File header, followed by events: op (1 byte), microseconds since the
+// previous event (varint), then the op's arguments
+static constexpr char _magic[8] = { 'S', 'S', 'S', 'A', 'T', 'R', 'C', 'E' };
+// Version 2 appended ops, version 1 traces read the same
+static constexpr uint8_t _version = 2;
+
+static constexpr std::string_view _op_names[] = {
+    "SourceCreate",
+    "SourceRemove",
+    "SourceUseBuffer",
+    "SourceQueueBuffers",
+    "SourceDetachBuffers",
+    "SourceStreamFile",
+    "SourcePlay",
+    "SourcePause",
+    "SourceStop",
+    "SourceSetGain",
+    "SourceSetLooping",
+    "SourceSetPropertyInt",
+    "SourceSetPropertyFloat",
+    "SourceSetBus",
+    "SourceSetValues",
+    "BufferCreate",
+    "BufferRemove",
+    "BufferLoadFile",
+    "SelectDevice",
+    "ConfigureDevice",
+    "SetMainVolume",
+    "BusCreate",
+    "BusRemove",
+    "BusSetParent",
+    "BusSetGain",
+    "BusSetMuted",
+    "BusSetPaused",
+    "BusDuckUnder",
+    "BusStopDucking",
+    "BusSetEffectSlot",
+    "BusClearEffectSlot",
+    "SourceFadeGain",
+    "SourceRampPitch",
+    "SourceMoveTo",
+    "SourceSetGainEnvelope",
+    "SourceSetPitchEnvelope",
+    "SourceStopAutomation",
+    "Crossfade",
+    "SourceSetDirectFilter",
+    "SourceSendTo",
+    "SourceClearSend",
+    "EffectSlotCreate",
+    "EffectSlotRemove",
+    "EffectSlotSetReverb",
+    "EffectSlotClearEffect",
+    "EffectSlotSetGain",
+    "EffectSlotAddZone",
+    "EffectSlotRemoveZone",
+    "EffectSlotClearZones",
+    "ContextCreate",
+    "ContextRemove",
+    "SourceSetContext",
+    "SetListenerGain",
+    "SetListenerPosition",
+    "SetListenerOrientation",
+};
+static_assert(std::size(_op_names) == static_cast<size_t>(TraceOp::Count));
+
+std::atomic<bool> recording{ false };
+
+struct Recorder {
+    std::mutex mutex;
+    std::ofstream file;
+    std::vector<uint8_t> buffer;
+    Clock::time_point last;
+};
+static Recorder _recorder;
+// Recorded calls in progress on this thread
+static thread_local uint32_t _depth = 0;
+
+static void _putVarint(std::vector<uint8_t>& out, uint64_t value)
+{
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+
+static void _putFloat(std::vector<uint8_t>& out, float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<uint8_t>(bits >> (8 * i)));
+    }
+}
+
+
+static void _putArg(std::vector<uint8_t>& out, TraceArg const& arg)
+{
+    switch (arg.type) {
+    case TraceArg::Type::UInt:
+        _putVarint(out, arg.u);
+        break;
+    case TraceArg::Type::Int:
+        // Zigzag, so that small negative values stay small
+        _putVarint(out, (static_cast<uint64_t>(arg.i) << 1) ^ static_cast<uint64_t>(arg.i >> 63));
+        break;
+    case TraceArg::Type::Float:
+        _putFloat(out, arg.f);
+        break;
+    case TraceArg::Type::String:
+        _putVarint(out, arg.s.size());
+        out.insert(out.end(), arg.s.cbegin(), arg.s.cend());
+        break;
+    case TraceArg::Type::IDs:
+        _putVarint(out, arg.ids.size());
+        for (uint32_t const id : arg.ids) {
+            _putVarint(out, id);
+        }
+        break;
+    case TraceArg::Type::Values:
+        _putVarint(out, arg.values->size());
+        for (SourceValue const& value : *arg.values) {
+            _putVarint(out, value.id);
+            _putVarint(out, static_cast<uint64_t>(value.param));
+            _putFloat(out, value.value);
+        }
+        break;
+    case TraceArg::Type::Points:
+        _putVarint(out, arg.points->size());
+        for (EnvelopePoint const& point : *arg.points) {
+            _putFloat(out, point.time);
+            _putFloat(out, point.value);
+        }
+        break;
+    }
+}
+
+
+void beginTraceCall(TraceOp op, std::initializer_list<TraceArg> args) noexcept try
+{
+    if (_depth++ != 0)
+        return;
+    std::lock_guard const lock(_recorder.mutex);
+    if (!_recorder.file.is_open())
+        return;
+    Clock::time_point const now = Clock::now();
+    auto const delta = std::chrono::duration_cast<std::chrono::microseconds>(now - _recorder.last);
+    _recorder.last = now;
+    std::vector<uint8_t>& out = _recorder.buffer;
+    out.push_back(static_cast<uint8_t>(op));
+    _putVarint(out, static_cast<uint64_t>(std::max<int64_t>(delta.count(), 0)));
+    for (TraceArg const& arg : args) {
+        _putArg(out, arg);
+    }
+    if (out.size() >= 65536) {
+        _recorder.file.write(reinterpret_cast<char const*>(out.data()), static_cast<std::streamsize>(out.size()));
+        out.clear();
+    }
+}
+CATCH_AND_LOG_FUNC_EXC;
+
+
+void endTraceCall() noexcept
+{
+    --_depth;
+}
+
+
+// Reads events back, throwing on truncated data
+class TraceReader {
+public:
+    TraceReader(std::vector<uint8_t> const& data, size_t position)
+        : _data(data), _position(position) {};
+
+    inline bool atEnd() const noexcept { return _position >= _data.size(); };
+
+    uint8_t byte()
+    {
+        _require(1);
+        return _data[_position++];
+    }
+    uint64_t varint()
+    {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t const b = byte();
+            value |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if ((b & 0x80) == 0)
+                return value;
+        }
+        SSS::throw_exc("Invalid trace varint.");
+        return 0;
+    }
+    uint32_t u32() { return static_cast<uint32_t>(varint()); };
+    int32_t i32()
+    {
+        uint64_t const value = varint();
+        return static_cast<int32_t>(static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1));
+    }
+    float f32()
+    {
+        _require(4);
+        uint32_t bits = 0;
+        for (int i = 0; i < 4; ++i) {
+            bits |= static_cast<uint32_t>(_data[_position++]) << (8 * i);
+        }
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    void string(std::string& out)
+    {
+        size_t const size = static_cast<size_t>(varint());
+        _require(size);
+        out.assign(reinterpret_cast<char const*>(_data.data() + _position), size);
+        _position += size;
+    }
+
+private:
+    void _require(size_t size) const
+    {
+        if (_data.size() - _position < size) {
+            SSS::throw_exc("Truncated trace.");
+        }
+    }
+
+    std::vector<uint8_t> const& _data;
+    size_t _position;
+};
+
+// Argument types of each op, in order: u (uint), i (int), f (float),
+// s (string), I (ids), V (Source values), P (envelope points)
+static constexpr std::string_view _op_signatures[] = {
+    "u",        // SourceCreate
+    "u",        // SourceRemove
+    "uu",       // SourceUseBuffer
+    "uI",       // SourceQueueBuffers
+    "u",        // SourceDetachBuffers
+    "us",       // SourceStreamFile
+    "u",        // SourcePlay
+    "u",        // SourcePause
+    "u",        // SourceStop
+    "uf",       // SourceSetGain
+    "uu",       // SourceSetLooping
+    "uii",      // SourceSetPropertyInt
+    "uif",      // SourceSetPropertyFloat
+    "us",       // SourceSetBus
+    "V",        // SourceSetValues
+    "u",        // BufferCreate
+    "u",        // BufferRemove
+    "us",       // BufferLoadFile
+    "s",        // SelectDevice
+    "iiiiiii",  // ConfigureDevice
+    "i",        // SetMainVolume
+    "ss",       // BusCreate
+    "s",        // BusRemove
+    "ss",       // BusSetParent
+    "sf",       // BusSetGain
+    "su",       // BusSetMuted
+    "su",       // BusSetPaused
+    "ssfff",    // BusDuckUnder
+    "ss",       // BusStopDucking
+    "su",       // BusSetEffectSlot
+    "s",        // BusClearEffectSlot
+    "uffi",     // SourceFadeGain
+    "uffi",     // SourceRampPitch
+    "uffffi",   // SourceMoveTo
+    "uPi",      // SourceSetGainEnvelope
+    "uPi",      // SourceSetPitchEnvelope
+    "u",        // SourceStopAutomation
+    "uufi",     // Crossfade
+    "uifff",    // SourceSetDirectFilter
+    "uuiifff",  // SourceSendTo
+    "ui",       // SourceClearSend
+    "u",        // EffectSlotCreate
+    "u",        // EffectSlotRemove
+    "ui",       // EffectSlotSetReverb
+    "u",        // EffectSlotClearEffect
+    "uf",       // EffectSlotSetGain
+    "ufffffi",  // EffectSlotAddZone
+    "uu",       // EffectSlotRemoveZone
+    "u",        // EffectSlotClearZones
+    "u",        // ContextCreate
+    "u",        // ContextRemove
+    "uu",       // SourceSetContext
+    "uf",       // SetListenerGain
+    "ufff",     // SetListenerPosition
+    "uffffff",  // SetListenerOrientation
+};
+static_assert(std::size(_op_signatures) == static_cast<size_t>(TraceOp::Count));
+
+// Arguments of the event being replayed, by type & order of appearance,
+// reused to keep allocations out of the stats
+struct ReplayCall {
+    TraceOp op{ TraceOp::Count };
+    std::array<uint32_t, 4> u{};
+    std::array<int32_t, 8> i{};
+    std::array<float, 8> f{};
+    std::array<std::string, 2> s;
+    std::vector<uint32_t> ids;
+    std::vector<SourceValue> values;
+    std::vector<EnvelopePoint> points;
+};
+
+static void _readCall(TraceReader& reader, ReplayCall& call)
+{
+    if (call.op >= TraceOp::Count) {
+        SSS::throw_exc(CONTEXT_MSG("Unknown trace op", static_cast<int>(call.op)));
+    }
+    size_t u = 0, i = 0, f = 0, s = 0;
+    for (char const type : _op_signatures[static_cast<size_t>(call.op)]) {
+        switch (type) {
+        case 'u':
+            call.u[u++] = reader.u32();
+            break;
+        case 'i':
+            call.i[i++] = reader.i32();
+            break;
+        case 'f':
+            call.f[f++] = reader.f32();
+            break;
+        case 's':
+            reader.string(call.s[s++]);
+            break;
+        case 'I':
+            call.ids.resize(static_cast<size_t>(reader.varint()));
+            for (uint32_t& id : call.ids) {
+                id = reader.u32();
+            }
+            break;
+        case 'V':
+            call.values.resize(static_cast<size_t>(reader.varint()));
+            for (SourceValue& value : call.values) {
+                value.id = reader.u32();
+                value.param = static_cast<SourceParam>(reader.u32());
+                value.value = reader.f32();
+            }
+            break;
+        case 'P':
+            call.points.resize(static_cast<size_t>(reader.varint()));
+            for (EnvelopePoint& point : call.points) {
+                point.time = reader.f32();
+                point.value = reader.f32();
+            }
+            break;
+        }
+    }
+}
+
+
+// Whether the op calls a method of the Source given as first argument
+static bool _isSourceMethod(TraceOp op) noexcept
+{
+    switch (op) {
+    case TraceOp::SourceCreate:
+    case TraceOp::SourceRemove:
+    case TraceOp::SourceSetValues:
+    case TraceOp::BufferCreate:
+    case TraceOp::BufferRemove:
+    case TraceOp::BufferLoadFile:
+    case TraceOp::SelectDevice:
+    case TraceOp::ConfigureDevice:
+    case TraceOp::SetMainVolume:
+    case TraceOp::Crossfade:
+    case TraceOp::EffectSlotCreate:
+    case TraceOp::EffectSlotRemove:
+    case TraceOp::EffectSlotSetReverb:
+    case TraceOp::EffectSlotClearEffect:
+    case TraceOp::EffectSlotSetGain:
+    case TraceOp::EffectSlotAddZone:
+    case TraceOp::EffectSlotRemoveZone:
+    case TraceOp::EffectSlotClearZones:
+    case TraceOp::ContextCreate:
+    case TraceOp::ContextRemove:
+    case TraceOp::SetListenerGain:
+    case TraceOp::SetListenerPosition:
+    case TraceOp::SetListenerOrientation:
+        return false;
+    default:
+        return op < TraceOp::BusCreate || op > TraceOp::BusClearEffectSlot;
+    }
+}
+
+
+static Filter _getFilter(ReplayCall const& call, size_t i, size_t f) noexcept
+{
+    Filter filter;
+    filter.type = static_cast<Filter::Type>(call.i[i]);
+    filter.gain = call.f[f];
+    filter.gain_hf = call.f[f + 1];
+    filter.gain_lf = call.f[f + 2];
+    return filter;
+}
+
+
+// Returns false if the call targets a missing Source, Buffer, Bus or
+// EffectSlot, as created before the recording started
+static bool _applyCall(ReplayCall const& call)
+{
+    Source* source = nullptr;
+    if (_isSourceMethod(call.op)) {
+        source = Source::get(call.u[0]);
+        if (!source)
+            return false;
+    }
+    Bus* bus = nullptr;
+    if (call.op >= TraceOp::BusRemove && call.op <= TraceOp::BusClearEffectSlot) {
+        bus = Bus::get(call.s[0]);
+        if (!bus)
+            return false;
+    }
+    EffectSlot* slot = nullptr;
+    if (call.op >= TraceOp::EffectSlotRemove && call.op <= TraceOp::EffectSlotClearZones) {
+        slot = EffectSlot::get(call.u[0]);
+        if (!slot)
+            return false;
+    }
+    switch (call.op) {
+    case TraceOp::SourceCreate:
+        Source::create(call.u[0]);
+        break;
+    case TraceOp::SourceRemove:
+        Source::remove(call.u[0]);
+        break;
+    case TraceOp::SourceUseBuffer:
+        source->useBuffer(call.u[1]);
+        break;
+    case TraceOp::SourceQueueBuffers:
+        source->queueBuffers(call.ids);
+        break;
+    case TraceOp::SourceDetachBuffers:
+        source->detachBuffers();
+        break;
+    case TraceOp::SourceStreamFile:
+        source->streamFile(call.s[0]);
+        break;
+    case TraceOp::SourcePlay:
+        source->play();
+        break;
+    case TraceOp::SourcePause:
+        source->pause();
+        break;
+    case TraceOp::SourceStop:
+        source->stop();
+        break;
+    case TraceOp::SourceSetGain:
+        source->setGain(call.f[0]);
+        break;
+    case TraceOp::SourceSetLooping:
+        source->setLooping(call.u[1] != 0);
+        break;
+    case TraceOp::SourceSetPropertyInt:
+        source->setPropertyInt(call.i[0], call.i[1]);
+        break;
+    case TraceOp::SourceSetPropertyFloat:
+        source->setPropertyFloat(call.i[0], call.f[0]);
+        break;
+    case TraceOp::SourceSetBus:
+        source->setBus(call.s[0]);
+        break;
+    case TraceOp::SourceSetValues:
+        Source::setValues(call.values);
+        break;
+    case TraceOp::BufferCreate:
+        Buffer::create(call.u[0]);
+        break;
+    case TraceOp::BufferRemove:
+        Buffer::remove(call.u[0]);
+        break;
+    case TraceOp::BufferLoadFile: {
+        Buffer* buffer = Buffer::get(call.u[0]);
+        if (!buffer)
+            return false;
+        buffer->loadFile(call.s[0]);
+        break;
+    }
+    case TraceOp::SelectDevice:
+        // Replays stay on the loopback device
+        break;
+    case TraceOp::ConfigureDevice: {
+        DeviceSettings settings;
+        settings.frequency = call.i[0];
+        settings.period_size = call.i[1];
+        settings.refresh = call.i[2];
+        settings.mono_sources = call.i[3];
+        settings.stereo_sources = call.i[4];
+        settings.max_sends = call.i[5];
+        settings.output_mode = static_cast<DeviceSettings::OutputMode>(call.i[6]);
+        settings.loopback = true;
+        configureDevice(settings);
+        break;
+    }
+    case TraceOp::SetMainVolume:
+        setMainVolume(call.i[0]);
+        break;
+    case TraceOp::BusCreate:
+        Bus::create(call.s[0], call.s[1]);
+        break;
+    case TraceOp::BusRemove:
+        Bus::remove(call.s[0]);
+        break;
+    case TraceOp::BusSetParent:
+        bus->setParent(call.s[1]);
+        break;
+    case TraceOp::BusSetGain:
+        bus->setGain(call.f[0]);
+        break;
+    case TraceOp::BusSetMuted:
+        bus->setMuted(call.u[0] != 0);
+        break;
+    case TraceOp::BusSetPaused:
+        bus->setPaused(call.u[0] != 0);
+        break;
+    case TraceOp::BusDuckUnder:
+        bus->duckUnder(call.s[1], call.f[0], call.f[1], call.f[2]);
+        break;
+    case TraceOp::BusStopDucking:
+        bus->stopDucking(call.s[1]);
+        break;
+    case TraceOp::BusSetEffectSlot:
+        bus->setEffectSlot(call.u[0]);
+        break;
+    case TraceOp::BusClearEffectSlot:
+        bus->clearEffectSlot();
+        break;
+    case TraceOp::SourceFadeGain:
+        source->fadeGain(call.f[0], call.f[1], static_cast<Curve>(call.i[0]));
+        break;
+    case TraceOp::SourceRampPitch:
+        source->rampPitch(call.f[0], call.f[1], static_cast<Curve>(call.i[0]));
+        break;
+    case TraceOp::SourceMoveTo:
+        source->moveTo(call.f[0], call.f[1], call.f[2], call.f[3], static_cast<Curve>(call.i[0]));
+        break;
+    case TraceOp::SourceSetGainEnvelope:
+        source->setGainEnvelope(call.points, static_cast<Curve>(call.i[0]));
+        break;
+    case TraceOp::SourceSetPitchEnvelope:
+        source->setPitchEnvelope(call.points, static_cast<Curve>(call.i[0]));
+        break;
+    case TraceOp::SourceStopAutomation:
+        source->stopAutomation();
+        break;
+    case TraceOp::Crossfade:
+        crossfade(call.u[0], call.u[1], call.f[0], static_cast<Curve>(call.i[0]));
+        break;
+    case TraceOp::SourceSetDirectFilter:
+        source->setDirectFilter(_getFilter(call, 0, 0));
+        break;
+    case TraceOp::SourceSendTo:
+        source->sendTo(call.u[1], call.i[0], _getFilter(call, 1, 0));
+        break;
+    case TraceOp::SourceClearSend:
+        source->clearSend(call.i[0]);
+        break;
+    case TraceOp::EffectSlotCreate:
+        EffectSlot::create(call.u[0]);
+        break;
+    case TraceOp::EffectSlotRemove:
+        EffectSlot::remove(call.u[0]);
+        break;
+    case TraceOp::EffectSlotSetReverb:
+        slot->setReverb(static_cast<ReverbPreset>(call.i[0]));
+        break;
+    case TraceOp::EffectSlotClearEffect:
+        slot->clearEffect();
+        break;
+    case TraceOp::EffectSlotSetGain:
+        slot->setGain(call.f[0]);
+        break;
+    case TraceOp::EffectSlotAddZone: {
+        ReverbZone zone;
+        zone.position = { call.f[0], call.f[1], call.f[2] };
+        zone.radius = call.f[3];
+        zone.blend = call.f[4];
+        zone.preset = static_cast<ReverbPreset>(call.i[0]);
+        // Zone ids are given in order, as when recorded
+        slot->addZone(zone);
+        break;
+    }
+    case TraceOp::EffectSlotRemoveZone:
+        slot->removeZone(call.u[1]);
+        break;
+    case TraceOp::EffectSlotClearZones:
+        slot->clearZones();
+        break;
+    case TraceOp::ContextCreate: {
+        uint32_t const context_id = createContext();
+        if (context_id != call.u[0]) {
+            LOG_FUNC_CTX_WRN("Replayed context got another id than recorded",
+                std::to_string(context_id) + " != " + std::to_string(call.u[0]));
+        }
+        break;
+    }
+    case TraceOp::ContextRemove:
+        removeContext(call.u[0]);
+        break;
+    case TraceOp::SourceSetContext:
+        source->setContext(call.u[1]);
+        break;
+    case TraceOp::SetListenerGain:
+        setListenerGain(call.u[0], call.f[0]);
+        break;
+    case TraceOp::SetListenerPosition:
+        setListenerPosition(call.u[0], call.f[0], call.f[1], call.f[2]);
+        break;
+    case TraceOp::SetListenerOrientation:
+        setListenerOrientation(call.u[0], { call.f[0], call.f[1], call.f[2] },
+            { call.f[3], call.f[4], call.f[5] });
+        break;
+    default:
+        break;
+    }
+    return true;
+}
+
+#ifdef SSS_AUDIO_COUNT_ALLOCATIONS
+static constexpr bool _counts_allocations = true;
+#else
+static constexpr bool _counts_allocations = false;
+#endif // SSS_AUDIO_COUNT_ALLOCATIONS
+
+static uint64_t _getAllocations() noexcept
+{
+#ifdef SSS_AUDIO_COUNT_ALLOCATIONS
+    return _allocations.load(std::memory_order_relaxed);
+#else
+    return 0;
+#endif // SSS_AUDIO_COUNT_ALLOCATIONS
+}
+
+
+static uint64_t _getAllocatedBytes() noexcept
+{
+#ifdef SSS_AUDIO_COUNT_ALLOCATIONS
+    return _allocated_bytes.load(std::memory_order_relaxed);
+#else
+    return 0;
+#endif // SSS_AUDIO_COUNT_ALLOCATIONS
+}
+
+INTERNAL_END;
+
+
+void startRecording(std::string const& filename) try
+{
+    stopRecording();
+    std::lock_guard const lock(_internal::_recorder.mutex);
+    _internal::_recorder.file.open(filename, std::ios::binary | std::ios::trunc);
+    if (!_internal::_recorder.file) {
+        SSS::throw_exc(CONTEXT_MSG("Couldn't open trace file", filename));
+    }
+    _internal::_recorder.file.write(_internal::_magic, sizeof(_internal::_magic));
+    _internal::_recorder.file.put(static_cast<char>(_internal::_version));
+    _internal::_recorder.buffer.reserve(65536 + 4096);
+    _internal::_recorder.last = _internal::Clock::now();
+    _internal::recording = true;
+}
+CATCH_AND_RETHROW_FUNC_EXC;
+
+
+void stopRecording() noexcept try
+{
+    _internal::recording = false;
+    std::lock_guard const lock(_internal::_recorder.mutex);
+    if (!_internal::_recorder.file.is_open())
+        return;
+    std::vector<uint8_t>& buffer = _internal::_recorder.buffer;
+    _internal::_recorder.file.write(reinterpret_cast<char const*>(buffer.data()),
+        static_cast<std::streamsize>(buffer.size()));
+    buffer.clear();
+    _internal::_recorder.file.close();
+}
+CATCH_AND_LOG_FUNC_EXC;
+
+
+bool isRecording() noexcept
+{
+    return _internal::recording;
+}
+
+
+ReplayStats replayTrace(std::string const& filename, ReplaySettings const& settings) try
+{
+    using _internal::Clock;
+    if (isRecording()) {
+        SSS::throw_exc("Can't replay a trace while recording one.");
+    }
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        SSS::throw_exc(CONTEXT_MSG("Couldn't open trace file", filename));
+    }
+    std::vector<uint8_t> const data{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+    if (data.size() < sizeof(_internal::_magic) + 1
+        || std::memcmp(data.data(), _internal::_magic, sizeof(_internal::_magic)) != 0
+        || data[sizeof(_internal::_magic)] == 0
+        || data[sizeof(_internal::_magic)] > _internal::_version)
+    {
+        SSS::throw_exc(CONTEXT_MSG("Not a supported trace file", filename));
+    }
+
+    // Headless device, mixing only when asked to
+    if (!_internal::is_init()) {
+        DeviceSettings device_settings = getDeviceSettings();
+        device_settings.loopback = true;
+        configureDevice(device_settings);
+        init();
+    }
+    if (!getDeviceInfo().loopback) {
+        SSS::throw_exc("Replays need a loopback device, see DeviceSettings::loopback.");
+    }
+    if (isThreadRunning()) {
+        LOG_CTX_WRN("SSS/Audio", "Audio thread running, its ticks will add to the replay.");
+    }
+    Source::clearAll();
+    Buffer::clearAll();
+    Bus::clearAll();
+    EffectSlot::clearAll();
+    for (uint32_t const context_id : getContexts()) {
+        if (context_id != 0) {
+            removeContext(context_id);
+        }
+    }
+
+    ReplayStats stats;
+    stats.counts_allocations = _internal::_counts_allocations;
+    stats.ops.resize(static_cast<size_t>(TraceOp::Count));
+    for (size_t i = 0; i < stats.ops.size(); ++i) {
+        stats.ops[i].name = _internal::_op_names[i];
+    }
+    int64_t const frequency = std::max(getDeviceInfo().frequency, 1);
+    int64_t const period_us = std::max<int64_t>(settings.tick_period.count(), 1);
+    std::vector<short> mix(static_cast<size_t>((period_us * frequency / 1000000 + 1) * 2));
+    uint64_t const allocations = _internal::_getAllocations();
+    uint64_t const allocated_bytes = _internal::_getAllocatedBytes();
+
+    // Mixes & ticks up to given trace time
+    int64_t trace_us = 0;
+    int64_t next_tick_us = period_us;
+    int64_t rendered_frames = 0;
+    auto const advance = [&](int64_t until_us) {
+        while (next_tick_us <= until_us) {
+            if (settings.render) {
+                int64_t const frames = next_tick_us * frequency / 1000000 - rendered_frames;
+                Clock::time_point const start = Clock::now();
+                renderMix(mix.data(), static_cast<size_t>(frames));
+                stats.render_ms += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+                rendered_frames += frames;
+            }
+            Clock::time_point const start = Clock::now();
+            update();
+            stats.update_ms += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            next_tick_us += period_us;
+        }
+    };
+
+    Clock::time_point const replay_start = Clock::now();
+    _internal::TraceReader reader(data, sizeof(_internal::_magic) + 1);
+    _internal::ReplayCall call;
+    while (!reader.atEnd()) {
+        call.op = static_cast<TraceOp>(reader.byte());
+        trace_us += static_cast<int64_t>(reader.varint());
+        _internal::_readCall(reader, call);
+        advance(trace_us);
+
+        ++stats.events;
+
+        TraceOpStats& op_stats = stats.ops[static_cast<size_t>(call.op)];
+        uint64_t const call_allocations = _internal::_getAllocations();
+        Clock::time_point const start = Clock::now();
+        bool applied = true;
+        try {
+            applied = _internal::_applyCall(call);
+        }
+        catch (std::exception const& e) {
+            LOG_FUNC_ERR(e.what());
+        }
+        if (!applied) {
+            ++stats.skipped;
+            continue;
+        }
+        double const us = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+        ++op_stats.count;
+        op_stats.total_us += us;
+        op_stats.max_us = std::max(op_stats.max_us, us);
+        op_stats.allocations += _internal::_getAllocations() - call_allocations;
+        stats.calls_ms += us / 1000.;
+    }
+    // Let the last sounds play out a tick
+    advance(trace_us + period_us);
+    stats.wall_ms = std::chrono::duration<double, std::milli>(Clock::now() - replay_start).count();
+    stats.trace_ms = static_cast<double>(trace_us) / 1000.;
+    stats.allocations = _internal::_getAllocations() - allocations;
+    stats.allocated_bytes = _internal::_getAllocatedBytes() - allocated_bytes;
+    std::erase_if(stats.ops, [](TraceOpStats const& op) { return op.count == 0; });
+    return stats;
+}
+CATCH_AND_RETHROW_FUNC_EXC;
+
+SSS_AUDIO_END;
\ No newline at end of file